@@ -54,6 +54,16 @@ mkdir -p "$PLUGIN_DIR"
 echo "Copying plugin file..."
 cp "$XPL_FILE" "$PLUGIN_DIR/"
 
+# Copy aircraft profiles (existing files with the same name are replaced)
+if [ -d "$PROJECT_DIR/profiles" ]; then
+    echo "Copying aircraft profiles..."
+    mkdir -p "$PLUGIN_DIR/profiles"
+    cp -p "$PROJECT_DIR"/profiles/*.profile "$PLUGIN_DIR/profiles/"
+    if [ -f "$PROJECT_DIR/profiles/profiles.pack" ]; then
+        cp -p "$PROJECT_DIR/profiles/profiles.pack" "$PLUGIN_DIR/profiles/"
+    fi
+fi
+
 # Verify installation
 if [ -f "$PLUGIN_DIR/mac.xpl" ]; then
     echo ""
@@ -0,0 +1,26 @@
+# LevelUp 737NG series (-600/-700/-900). The aircraft is derived from the ZIBO 737 and
+# uses the same CDU commands, but reports its own ICAO codes.
+#
+# Copy this file to the plugin's profiles/ folder:
+#   X-Plane/Resources/plugins/ZIBOKeyboardInput/profiles/
+# See README "Aircraft Profiles" for every setting.
+
+name = LevelUp 737NG
+label = 737
+icao = B736, B737, B739
+require_command = laminar/B738/button/fmc1_0
+
+dual_fmc = yes
+command_format = laminar/B738/button/fmc%d_%s
+letters = upper
+key.CLR = clr
+key.SP = SP
+key.DEL = del
+key.ENT = ent
+key.SLASH = slash
+key.PERIOD = period
+repeat.CLR = hold
+
+plus_minus = toggle
+minus_command = laminar/B738/button/fmc%d_minus
+scratchpad_dataref = laminar/B738/fmc%d/Line_entry
@@ -0,0 +1,492 @@
+// Aircraft profile text parser (see AircraftProfile.h)
+//
+// A profile file is a list of "key = value" lines; '#' starts a comment. Formats and key
+// names are validated and expanded here, once, into AircraftProfile::commands.
+
+#include "AircraftProfile.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+static const char* const g_profile_button_names[BUTTON_COUNT] = {
+    nullptr,
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+    "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M",
+    "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z",
+    "CLR", "SP", "DEL", "ENT", "SLASH", "PERIOD", "MINUS", "PLUS"
+};
+
+static const size_t KEY_NAME_SIZE = 32;
+static const size_t FORMAT_SIZE = COMMAND_NAME_SIZE;
+
+const char* ProfileButtonName(ButtonId button)
+{
+    return (button < BUTTON_COUNT) ? g_profile_button_names[button] : nullptr;
+}
+
+RepeatPolicy DefaultRepeatPolicy(ButtonId button)
+{
+    return (button == BUTTON_CLR) ? REPEAT_PASS : REPEAT_DROP;
+}
+
+static ButtonId FindProfileButton(const char* name)
+{
+    for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+        if (strcmp(g_profile_button_names[button], name) == 0) {
+            return (ButtonId)button;
+        }
+    }
+    return BUTTON_NONE;
+}
+
+// Values as written in the file, before validation and expansion
+struct ProfileSource {
+    char command_format[FORMAT_SIZE];
+    char command_format_capt[FORMAT_SIZE];
+    char command_format_fo[FORMAT_SIZE];
+    char minus_command[FORMAT_SIZE];
+    char minus_command_capt[FORMAT_SIZE];
+    char minus_command_fo[FORMAT_SIZE];
+    char scratchpad_dataref[FORMAT_SIZE];
+    char key_names[BUTTON_COUNT][KEY_NAME_SIZE];   // Empty = key not supported
+    bool lowercase_letters;
+    bool plus_minus_set;
+    bool repeat_set;                               // "repeat" given: replaces DefaultRepeatPolicy
+    RepeatPolicy repeat_policy;
+    uint8_t repeat_rate;
+};
+
+static void SetError(char* error, size_t error_size, const char* source, int line, const char* format, ...)
+{
+    int written = snprintf(error, error_size, "%s:%d: ", source, line);
+    if (written < 0 || (size_t)written >= error_size) return;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error + written, error_size - written, format, args);
+    va_end(args);
+}
+
+static char* Trim(char* text)
+{
+    while (*text != '\0' && isspace((unsigned char)*text)) text++;
+    char* end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return text;
+}
+
+// Copy a value that must fit the destination; returns false if it is too long
+static bool CopyValue(char* destination, size_t size, const char* value)
+{
+    size_t length = strlen(value);
+    if (length >= size) return false;
+    memcpy(destination, value, length + 1);
+    return true;
+}
+
+static bool ParseBool(const char* value, bool* out)
+{
+    if (strcmp(value, "yes") == 0 || strcmp(value, "true") == 0 || strcmp(value, "1") == 0) {
+        *out = true;
+        return true;
+    }
+    if (strcmp(value, "no") == 0 || strcmp(value, "false") == 0 || strcmp(value, "0") == 0) {
+        *out = false;
+        return true;
+    }
+    return false;
+}
+
+static bool IsValidKeyName(const char* name)
+{
+    if (name[0] == '\0') return false;
+    for (size_t i = 0; name[i] != '\0'; i++) {
+        if (name[i] == '%' || isspace((unsigned char)name[i])) return false;
+    }
+    return true;
+}
+
+// Expand a format into a command name; fails if the result would not fit COMMAND_NAME_SIZE
+static bool ExpandCommandName(const char* format, int side, const char* key_name, CommandName* out)
+{
+    size_t expected = strlen(format) - 2 * (CountConversions(format, 'd') + CountConversions(format, 's'))
+                    + CountConversions(format, 'd') + CountConversions(format, 's') * strlen(key_name);
+    if (expected >= COMMAND_NAME_SIZE) return false;
+    *out = FormatCommandName(format, side, key_name);
+    return true;
+}
+
+// Add the items of a comma-separated list to a fixed array of strings (items is the first
+// of max_items strings, item_size bytes apart); the key may be repeated to add more
+static bool AppendListItems(const char* value, const char* what, char* items, size_t item_size, int max_items, int* count,
+                            const char* source, int line, char* error, size_t error_size)
+{
+    char list[256];
+    if (!CopyValue(list, sizeof(list), value)) {
+        SetError(error, error_size, source, line, "list of %s is too long", what);
+        return false;
+    }
+    // Split by hand: strtok keeps process-wide state, and profiles are also parsed on the
+    // watcher thread
+    for (char* next = list; next != nullptr; ) {
+        char* item = next;
+        char* comma = strchr(item, ',');
+        next = (comma != nullptr) ? comma + 1 : nullptr;
+        if (comma != nullptr) *comma = '\0';
+        item = Trim(item);
+        if (item[0] == '\0') continue;
+        if (*count >= max_items) {
+            SetError(error, error_size, source, line, "at most %d %s per profile", max_items, what);
+            return false;
+        }
+        if (!CopyValue(items + *count * item_size, item_size, item)) {
+            SetError(error, error_size, source, line, "'%s' is too long (at most %d characters)", item, (int)item_size - 1);
+            return false;
+        }
+        (*count)++;
+    }
+    return true;
+}
+
+// "pass", "drop", "hold" or presses per second
+static bool ParseRepeatPolicy(const char* value, RepeatPolicy* policy, uint8_t* rate)
+{
+    *rate = 0;
+    if (strcmp(value, "pass") == 0) *policy = REPEAT_PASS;
+    else if (strcmp(value, "drop") == 0) *policy = REPEAT_DROP;
+    else if (strcmp(value, "hold") == 0) *policy = REPEAT_HOLD;
+    else {
+        char* end = nullptr;
+        long per_second = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || per_second < 1 || per_second > PROFILE_MAX_REPEAT_RATE) return false;
+        *policy = REPEAT_RATE_LIMIT;
+        *rate = (uint8_t)per_second;
+    }
+    return true;
+}
+
+// Apply one "key = value" line
+static bool ApplySetting(const char* key, const char* value, AircraftProfile* profile, ProfileSource* source_values,
+                         const char* source, int line, char* error, size_t error_size)
+{
+    struct { const char* key; char* destination; } formats[] = {
+        {"command_format", source_values->command_format},
+        {"command_format_capt", source_values->command_format_capt},
+        {"command_format_fo", source_values->command_format_fo},
+        {"minus_command", source_values->minus_command},
+        {"minus_command_capt", source_values->minus_command_capt},
+        {"minus_command_fo", source_values->minus_command_fo},
+        {"scratchpad_dataref", source_values->scratchpad_dataref},
+    };
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strcmp(key, formats[i].key) == 0) {
+            if (!CopyValue(formats[i].destination, FORMAT_SIZE, value)) {
+                SetError(error, error_size, source, line, "%s is longer than %d characters", key, (int)FORMAT_SIZE - 1);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    if (strcmp(key, "name") == 0) {
+        if (value[0] == '\0' || !CopyValue(profile->name, sizeof(profile->name), value)) {
+            SetError(error, error_size, source, line, "name must be 1-%d characters", (int)sizeof(profile->name) - 1);
+            return false;
+        }
+    } else if (strcmp(key, "label") == 0) {
+        if (!CopyValue(profile->status_label, sizeof(profile->status_label), value)) {
+            SetError(error, error_size, source, line, "label must be at most %d characters", (int)sizeof(profile->status_label) - 1);
+            return false;
+        }
+    } else if (strcmp(key, "icao") == 0) {
+        return AppendListItems(value, "ICAO codes", profile->icao[0], PROFILE_ICAO_SIZE, PROFILE_MAX_ICAOS,
+                               &profile->icao_count, source, line, error, error_size);
+    } else if (strcmp(key, "acf_file") == 0) {
+        return AppendListItems(value, ".acf files", profile->acf_files[0], PROFILE_ACF_FILE_SIZE, PROFILE_MAX_ACF_FILES,
+                               &profile->acf_file_count, source, line, error, error_size);
+    } else if (strcmp(key, "require_command") == 0) {
+        return AppendListItems(value, "required commands", profile->require_commands[0].text, sizeof(CommandName),
+                               PROFILE_MAX_PROBES, &profile->require_count, source, line, error, error_size);
+    } else if (strcmp(key, "reject_command") == 0) {
+        return AppendListItems(value, "rejected commands", profile->reject_commands[0].text, sizeof(CommandName),
+                               PROFILE_MAX_PROBES, &profile->reject_count, source, line, error, error_size);
+    } else if (strcmp(key, "author") == 0 || strcmp(key, "studio") == 0) {
+        char* destination = (key[0] == 'a') ? profile->author : profile->studio;
+        if (!CopyValue(destination, PROFILE_AUTHOR_SIZE, value)) {
+            SetError(error, error_size, source, line, "%s must be at most %d characters", key, (int)PROFILE_AUTHOR_SIZE - 1);
+            return false;
+        }
+    } else if (strcmp(key, "priority") == 0) {
+        char* end = nullptr;
+        long priority = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || priority < -1000 || priority > 1000) {
+            SetError(error, error_size, source, line, "priority must be an integer from -1000 to 1000");
+            return false;
+        }
+        profile->priority = (int)priority;
+    } else if (strcmp(key, "dual_fmc") == 0) {
+        if (!ParseBool(value, &profile->has_side_specific_fmc)) {
+            SetError(error, error_size, source, line, "dual_fmc must be yes or no");
+            return false;
+        }
+    } else if (strcmp(key, "scratchpad_write") == 0) {
+        if (!ParseBool(value, &profile->scratchpad_write)) {
+            SetError(error, error_size, source, line, "scratchpad_write must be yes or no");
+            return false;
+        }
+    } else if (strcmp(key, "scratchpad_size") == 0) {
+        char* end = nullptr;
+        long size = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || size < 1 || size > PROFILE_MAX_SCRATCHPAD_SIZE) {
+            SetError(error, error_size, source, line, "scratchpad_size must be an integer from 1 to %d", PROFILE_MAX_SCRATCHPAD_SIZE);
+            return false;
+        }
+        profile->scratchpad_size = (uint8_t)size;
+    } else if (strcmp(key, "letters") == 0) {
+        if (strcmp(value, "upper") != 0 && strcmp(value, "lower") != 0) {
+            SetError(error, error_size, source, line, "letters must be upper or lower");
+            return false;
+        }
+        source_values->lowercase_letters = (strcmp(value, "lower") == 0);
+    } else if (strcmp(key, "plus_minus") == 0) {
+        if (strcmp(value, "toggle") == 0) profile->plus_minus = PLUS_MINUS_TOGGLE;
+        else if (strcmp(value, "keys") == 0) profile->plus_minus = PLUS_MINUS_KEYS;
+        else if (strcmp(value, "none") == 0) profile->plus_minus = PLUS_MINUS_NONE;
+        else {
+            SetError(error, error_size, source, line, "plus_minus must be toggle, keys or none");
+            return false;
+        }
+        source_values->plus_minus_set = true;
+    } else if (strcmp(key, "repeat") == 0 || strncmp(key, "repeat.", 7) == 0) {
+        ButtonId button = (key[6] == '.') ? FindProfileButton(key + 7) : BUTTON_NONE;
+        if (key[6] == '.' && button == BUTTON_NONE) {
+            SetError(error, error_size, source, line, "unknown button '%s'", key + 7);
+            return false;
+        }
+        RepeatPolicy policy;
+        uint8_t rate;
+        if (!ParseRepeatPolicy(value, &policy, &rate)) {
+            SetError(error, error_size, source, line, "%s must be pass, drop, hold or presses per second (1-%d)",
+                     key, PROFILE_MAX_REPEAT_RATE);
+            return false;
+        }
+        if (button == BUTTON_NONE) {
+            source_values->repeat_set = true;
+            source_values->repeat_policy = policy;
+            source_values->repeat_rate = rate;
+        } else {
+            profile->repeat_policy[button] = policy;
+            profile->repeat_rate[button] = rate;
+        }
+    } else if (strncmp(key, "key.", 4) == 0) {
+        ButtonId button = FindProfileButton(key + 4);
+        if (button == BUTTON_NONE) {
+            SetError(error, error_size, source, line, "unknown button '%s'", key + 4);
+            return false;
+        }
+        if (strcmp(value, "none") == 0) {
+            source_values->key_names[button][0] = '\0';
+        } else if (!IsValidKeyName(value) || !CopyValue(source_values->key_names[button], KEY_NAME_SIZE, value)) {
+            SetError(error, error_size, source, line, "key name '%s' must be 1-%d characters without spaces or '%%'", value, (int)KEY_NAME_SIZE - 1);
+            return false;
+        }
+    } else {
+        SetError(error, error_size, source, line, "unknown setting '%s'", key);
+        return false;
+    }
+    return true;
+}
+
+bool ParseAircraftProfile(const char* text, size_t length, const char* source, AircraftProfile* outProfile,
+                          char* error, size_t error_size)
+{
+    AircraftProfile profile;
+    memset(&profile, 0, sizeof(profile));
+    ProfileSource values;
+    memset(&values, 0, sizeof(values));
+
+    // Letters follow the "letters" setting unless overridden; digits are always 0-9
+    bool letter_overridden[BUTTON_COUNT] = {};
+    // Likewise repeat policies follow "repeat" (or the defaults) unless set per key
+    bool repeat_overridden[BUTTON_COUNT] = {};
+
+    int line_number = 0;
+    size_t position = 0;
+    while (position < length) {
+        size_t line_end = position;
+        while (line_end < length && text[line_end] != '\n') line_end++;
+        line_number++;
+
+        char line[256];
+        size_t line_length = line_end - position;
+        if (line_length >= sizeof(line)) {
+            SetError(error, error_size, source, line_number, "line is too long");
+            return false;
+        }
+        memcpy(line, text + position, line_length);
+        line[line_length] = '\0';
+        position = line_end + 1;
+
+        char* comment = strchr(line, '#');
+        if (comment != nullptr) *comment = '\0';
+        char* content = Trim(line);
+        if (content[0] == '\0') continue;
+
+        char* equals = strchr(content, '=');
+        if (equals == nullptr) {
+            SetError(error, error_size, source, line_number, "expected 'setting = value'");
+            return false;
+        }
+        *equals = '\0';
+        char* key = Trim(content);
+        char* value = Trim(equals + 1);
+        if (!ApplySetting(key, value, &profile, &values, source, line_number, error, error_size)) {
+            return false;
+        }
+        if (strncmp(key, "key.", 4) == 0) {
+            letter_overridden[FindProfileButton(key + 4)] = true;
+        } else if (strncmp(key, "repeat.", 7) == 0) {
+            repeat_overridden[FindProfileButton(key + 7)] = true;
+        }
+    }
+
+    // Required settings and defaults
+    if (profile.name[0] == '\0') {
+        SetError(error, error_size, source, line_number, "missing name");
+        return false;
+    }
+    if (profile.icao_count == 0 && profile.acf_file_count == 0) {
+        SetError(error, error_size, source, line_number, "missing icao (or acf_file)");
+        return false;
+    }
+    if (profile.status_label[0] == '\0') {
+        snprintf(profile.status_label, sizeof(profile.status_label), "%s", profile.icao_count ? profile.icao[0] : profile.name);
+    }
+    for (int button = BUTTON_0; button <= BUTTON_9; button++) {
+        if (!letter_overridden[button]) {
+            snprintf(values.key_names[button], KEY_NAME_SIZE, "%c", '0' + (button - BUTTON_0));
+        }
+    }
+    for (int button = BUTTON_A; button <= BUTTON_Z; button++) {
+        if (!letter_overridden[button]) {
+            snprintf(values.key_names[button], KEY_NAME_SIZE, "%c", (values.lowercase_letters ? 'a' : 'A') + (button - BUTTON_A));
+        }
+    }
+    for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+        if (repeat_overridden[button]) continue;
+        profile.repeat_policy[button] = values.repeat_set ? values.repeat_policy : DefaultRepeatPolicy((ButtonId)button);
+        profile.repeat_rate[button] = values.repeat_set ? values.repeat_rate : 0;
+    }
+    bool has_minus_command = values.minus_command[0] || values.minus_command_capt[0] || values.minus_command_fo[0];
+    if (!values.plus_minus_set) {
+        profile.plus_minus = has_minus_command ? PLUS_MINUS_TOGGLE : PLUS_MINUS_NONE;
+    }
+
+    if (profile.scratchpad_write && values.scratchpad_dataref[0] == '\0') {
+        SetError(error, error_size, source, line_number, "scratchpad_write needs a scratchpad_dataref");
+        return false;
+    }
+
+    // Key command formats: one shared format, or one per side
+    bool per_side_formats = values.command_format_capt[0] && values.command_format_fo[0];
+    if (!per_side_formats && values.command_format[0] == '\0') {
+        SetError(error, error_size, source, line_number, "missing command_format (or command_format_capt and command_format_fo)");
+        return false;
+    }
+    if (per_side_formats && !profile.has_side_specific_fmc) {
+        SetError(error, error_size, source, line_number, "command_format_capt/command_format_fo need dual_fmc = yes");
+        return false;
+    }
+
+    int side_count = profile.has_side_specific_fmc ? 2 : 1;
+    for (int side = 1; side <= side_count; side++) {
+        const char* key_format = per_side_formats ? ((side == 1) ? values.command_format_capt : values.command_format_fo)
+                                                  : values.command_format;
+        // Exactly one key name; a side number only where one format is shared by both sides
+        int expected_sides = (!per_side_formats && profile.has_side_specific_fmc) ? 1 : 0;
+        if (CountConversions(key_format, 's') != 1 || CountConversions(key_format, 'd') != expected_sides) {
+            SetError(error, error_size, source, line_number, "command format '%s' must contain one %%s%s", key_format,
+                     expected_sides ? " and one %d" : " and no other conversions");
+            return false;
+        }
+
+        for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+            // +/- keys go through the minus command unless the aircraft has real MINUS/PLUS keys
+            if ((button == BUTTON_MINUS || button == BUTTON_PLUS) && profile.plus_minus != PLUS_MINUS_KEYS) continue;
+            const char* key_name = values.key_names[button];
+            if (key_name[0] == '\0') continue;
+            if (!ExpandCommandName(key_format, side, key_name, &profile.commands.keys[side - 1][button])) {
+                SetError(error, error_size, source, line_number, "command for key %s does not fit %d characters",
+                         g_profile_button_names[button], (int)COMMAND_NAME_SIZE - 1);
+                return false;
+            }
+        }
+
+        if (profile.plus_minus == PLUS_MINUS_TOGGLE) {
+            bool per_side_minus = values.minus_command_capt[0] && values.minus_command_fo[0];
+            const char* minus_format = per_side_minus ? ((side == 1) ? values.minus_command_capt : values.minus_command_fo)
+                                                      : values.minus_command;
+            int minus_sides = CountConversions(minus_format, 'd');
+            if (minus_format[0] == '\0' || CountConversions(minus_format, 's') != 0 || minus_sides < 0 || minus_sides > 1 ||
+                (minus_sides == 1 && !profile.has_side_specific_fmc)) {
+                SetError(error, error_size, source, line_number, "plus_minus = toggle needs a minus_command (with %%d only for dual_fmc)");
+                return false;
+            }
+            ExpandCommandName(minus_format, side, "", &profile.commands.minus[side - 1]);
+        } else if (profile.plus_minus == PLUS_MINUS_KEYS &&
+                   (values.key_names[BUTTON_MINUS][0] == '\0' || values.key_names[BUTTON_PLUS][0] == '\0')) {
+            SetError(error, error_size, source, line_number, "plus_minus = keys needs key.MINUS and key.PLUS");
+            return false;
+        }
+
+        if (values.scratchpad_dataref[0] != '\0') {
+            int scratchpad_sides = CountConversions(values.scratchpad_dataref, 'd');
+            if (CountConversions(values.scratchpad_dataref, 's') != 0 || scratchpad_sides < 0 || scratchpad_sides > 1 ||
+                (scratchpad_sides == 1 && !profile.has_side_specific_fmc)) {
+                SetError(error, error_size, source, line_number, "scratchpad_dataref may only contain %%d, and only for dual_fmc");
+                return false;
+            }
+            ExpandCommandName(values.scratchpad_dataref, side, "", &profile.commands.scratchpad[side - 1]);
+        }
+    }
+
+    *outProfile = profile;
+    return true;
+}
+
+ProfileAddResult AddAircraftProfile(std::vector<AircraftProfile>* profiles, size_t builtin_count, const AircraftProfile& profile)
+{
+    for (size_t i = 0; i < profiles->size(); i++) {
+        AircraftProfile& existing = (*profiles)[i];
+        if (strcmp(existing.name, profile.name) != 0) continue;
+        if (i >= builtin_count) return PROFILE_DUPLICATE_NAME;
+        uint8_t session_code = existing.session_code;
+        existing = profile;
+        existing.session_code = session_code;
+        return PROFILE_REPLACED_BUILTIN;
+    }
+    profiles->push_back(profile);
+    return PROFILE_ADDED;
+}
+
+// Detection rules beyond the ICAO; more rules = more specific
+static int CountDetectionRules(const AircraftProfile& profile)
+{
+    return (profile.acf_file_count > 0) + (profile.author[0] != '\0') + (profile.studio[0] != '\0') +
+           profile.require_count + profile.reject_count;
+}
+
+void SortAircraftProfiles(std::vector<AircraftProfile>* profiles, size_t builtin_count)
+{
+    // File profiles go ahead of the built-ins so they win ties; the sort keeps that order
+    std::rotate(profiles->begin(), profiles->begin() + builtin_count, profiles->end());
+    std::stable_sort(profiles->begin(), profiles->end(), [](const AircraftProfile& a, const AircraftProfile& b) {
+        if (a.priority != b.priority) return a.priority > b.priority;
+        return CountDetectionRules(a) > CountDetectionRules(b);
+    });
+}
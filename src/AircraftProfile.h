@@ -0,0 +1,181 @@
+// Aircraft profiles: logical FMC buttons, command names and the profile text format
+//
+// A profile describes one aircraft: how to recognise it, the command behind every logical
+// FMC button on each side, how +/- works and what the status window shows. The built-in
+// aircraft are compiled into the plugin; more are loaded from "*.profile" files in the
+// plugin's profiles/ folder. Either way a profile ends up as flat arrays of fully expanded
+// command names indexed by [side - 1][ButtonId], so key dispatch cost does not depend on
+// how many profiles are installed.
+
+#ifndef AIRCRAFT_PROFILE_H
+#define AIRCRAFT_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// Logical FMC buttons shared by every aircraft; compact IDs used instead of key name strings
+enum ButtonId : uint8_t {
+    BUTTON_NONE = 0,                 // Virtual key not handled by the plugin
+    BUTTON_0, BUTTON_1, BUTTON_2, BUTTON_3, BUTTON_4,
+    BUTTON_5, BUTTON_6, BUTTON_7, BUTTON_8, BUTTON_9,
+    BUTTON_A, BUTTON_B, BUTTON_C, BUTTON_D, BUTTON_E, BUTTON_F, BUTTON_G,
+    BUTTON_H, BUTTON_I, BUTTON_J, BUTTON_K, BUTTON_L, BUTTON_M, BUTTON_N,
+    BUTTON_O, BUTTON_P, BUTTON_Q, BUTTON_R, BUTTON_S, BUTTON_T, BUTTON_U,
+    BUTTON_V, BUTTON_W, BUTTON_X, BUTTON_Y, BUTTON_Z,
+    BUTTON_CLR,                      // Clear
+    BUTTON_SP,                       // Space
+    BUTTON_DEL,                      // Delete
+    BUTTON_ENT,                      // Enter
+    BUTTON_SLASH,                    // Forward slash
+    BUTTON_PERIOD,                   // Period/decimal point
+    BUTTON_MINUS,                    // Minus sign -> smart +/- handling
+    BUTTON_PLUS,                     // Plus sign -> smart +/- handling
+    BUTTON_COUNT
+};
+
+// Command names are expanded from formats with only the "%d" (FMC side) and "%s" (key
+// name) conversions
+static constexpr size_t COMMAND_NAME_SIZE = 64;
+
+struct CommandName {
+    char text[COMMAND_NAME_SIZE];    // Empty string = no command for this button
+};
+
+struct AircraftCommandNames {
+    CommandName keys[2][BUTTON_COUNT];   // [side - 1][ButtonId]
+    CommandName minus[2];                // +/- toggle command per side
+    CommandName scratchpad[2];           // Byte array dataref with the side's scratchpad text
+};
+
+constexpr size_t ConstexprLength(const char* text)
+{
+    size_t length = 0;
+    while (text[length] != '\0') length++;
+    return length;
+}
+
+// Count occurrences of a conversion ("%d" or "%s"); returns -1 for any other '%' use
+constexpr int CountConversions(const char* format, char conversion)
+{
+    int count = 0;
+    for (size_t i = 0; format[i] != '\0'; i++) {
+        if (format[i] != '%') continue;
+        char next = format[i + 1];
+        if (next != 'd' && next != 's') return -1;
+        if (next == conversion) count++;
+        i++;
+    }
+    return count;
+}
+
+// Expand a command format with the FMC side and key name
+constexpr CommandName FormatCommandName(const char* format, int side, const char* key_name)
+{
+    CommandName name = {};
+    size_t out = 0;
+    for (size_t i = 0; format[i] != '\0' && out < COMMAND_NAME_SIZE - 1; i++) {
+        if (format[i] == '%' && format[i + 1] == 'd') {
+            name.text[out++] = static_cast<char>('0' + side);
+            i++;
+        } else if (format[i] == '%' && format[i + 1] == 's') {
+            for (size_t k = 0; key_name[k] != '\0' && out < COMMAND_NAME_SIZE - 1; k++) {
+                name.text[out++] = key_name[k];
+            }
+            i++;
+        } else {
+            name.text[out++] = format[i];
+        }
+    }
+    return name;
+}
+
+// How the aircraft's +/- key works
+enum PlusMinusMode : uint8_t {
+    PLUS_MINUS_NONE = 0,             // No +/- key (e.g., SR22 GCU)
+    PLUS_MINUS_TOGGLE,               // One minus command toggles the sign (Boeing CDU)
+    PLUS_MINUS_KEYS                  // Separate MINUS/PLUS key commands, sent like any key
+};
+
+// What a key does when the OS auto-repeats it (more down events while it is held)
+enum RepeatPolicy : uint8_t {
+    REPEAT_DROP = 0,                 // Ignore repeats
+    REPEAT_PASS,                     // Every repeat is another key press
+    REPEAT_RATE_LIMIT,               // Repeats are key presses, at most repeat_rate per second
+    REPEAT_HOLD                      // The first repeat holds the key's FMC button down until key up
+};
+
+static constexpr int PROFILE_MAX_REPEAT_RATE = 50;
+static constexpr int PROFILE_MAX_ICAOS = 4;
+static constexpr int PROFILE_MAX_ACF_FILES = 4;
+static constexpr int PROFILE_MAX_PROBES = 4;
+static constexpr size_t PROFILE_NAME_SIZE = 48;
+static constexpr size_t PROFILE_LABEL_SIZE = 8;
+static constexpr size_t PROFILE_ICAO_SIZE = 8;
+static constexpr size_t PROFILE_ACF_FILE_SIZE = 64;
+static constexpr size_t PROFILE_AUTHOR_SIZE = 48;
+static constexpr int PROFILE_MAX_SCRATCHPAD_SIZE = 255;
+
+struct AircraftProfile {
+    char name[PROFILE_NAME_SIZE];
+    char status_label[PROFILE_LABEL_SIZE];    // Status window text for single-FMC aircraft
+
+    // Detection (see AircraftFingerprint in ProfilePack.h). Every rule a profile declares
+    // must hold: the ICAO matches one entry, the .acf file name matches one entry (case
+    // insensitive), author/studio contain the given text (case insensitive), every
+    // require command exists and no reject command does. A profile needs an ICAO or an
+    // .acf file rule. Higher priority profiles are tried first.
+    char icao[PROFILE_MAX_ICAOS][PROFILE_ICAO_SIZE];
+    int icao_count;
+    char acf_files[PROFILE_MAX_ACF_FILES][PROFILE_ACF_FILE_SIZE];
+    int acf_file_count;
+    char author[PROFILE_AUTHOR_SIZE];
+    char studio[PROFILE_AUTHOR_SIZE];
+    CommandName require_commands[PROFILE_MAX_PROBES];
+    int require_count;
+    CommandName reject_commands[PROFILE_MAX_PROBES];
+    int reject_count;
+    int priority;
+
+    bool has_side_specific_fmc;               // Separate Captain/FO FMCs
+    PlusMinusMode plus_minus;
+    bool scratchpad_write;                    // Type text by writing the scratchpad dataref
+    uint8_t scratchpad_size;                  // Scratchpad dataref capacity in bytes; 0 = ask the dataref
+    uint8_t session_code;                     // FMCSessionAircraft for the built-in aircraft, else 0
+    AircraftCommandNames commands;
+    RepeatPolicy repeat_policy[BUTTON_COUNT];
+    uint8_t repeat_rate[BUTTON_COUNT];        // Presses per second for REPEAT_RATE_LIMIT, else 0
+};
+
+// Button name used in profile files ("0"-"9", "A"-"Z", "CLR", "SP", "DEL", "ENT", "SLASH",
+// "PERIOD", "MINUS", "PLUS"); nullptr for BUTTON_NONE
+const char* ProfileButtonName(ButtonId button);
+
+// Auto-repeat policy of a key unless a profile sets one: a held CLR keeps clearing one
+// character per repeat, as it always has, every other key ignores repeats
+RepeatPolicy DefaultRepeatPolicy(ButtonId button);
+
+// Parse one profile file (see README "Aircraft Profiles" for the format). On failure returns
+// false with a "source:line: reason" message in error.
+bool ParseAircraftProfile(const char* text, size_t length, const char* source, AircraftProfile* outProfile,
+                          char* error, size_t error_size);
+
+// Append the built-in aircraft (BuiltinProfiles.cpp)
+void AppendBuiltinProfiles(std::vector<AircraftProfile>* profiles);
+
+enum ProfileAddResult {
+    PROFILE_ADDED = 0,
+    PROFILE_REPLACED_BUILTIN,        // Same name as a built-in aircraft, which it replaces
+    PROFILE_DUPLICATE_NAME           // Same name as another profile file; not added
+};
+
+// Add a profile file to a list that starts with builtin_count built-in profiles. A profile
+// replacing a built-in keeps its session recording code.
+ProfileAddResult AddAircraftProfile(std::vector<AircraftProfile>* profiles, size_t builtin_count, const AircraftProfile& profile);
+
+// Put profiles in detection order: higher priority first, and at equal priority profiles
+// with more detection rules (the more specific match) first. File profiles win remaining ties.
+void SortAircraftProfiles(std::vector<AircraftProfile>* profiles, size_t builtin_count);
+
+#endif // AIRCRAFT_PROFILE_H
@@ -0,0 +1,110 @@
+// Persistent command availability cache (see AvailabilityCache.h)
+
+#include "AvailabilityCache.h"
+#include "ProfilePack.h"
+
+#include <stdio.h>
+#include <string.h>
+
+AvailabilityCache::AvailabilityCache()
+    : m_sequence(0), m_changed(false)
+{
+}
+
+bool AvailabilityCache::Load(const char* path)
+{
+    m_entries.clear();
+    m_sequence = 0;
+    m_changed = false;
+
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) return false;
+    FMCAvailabilityHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 memcmp(header.magic, FMC_AVAILABILITY_MAGIC, sizeof(FMC_AVAILABILITY_MAGIC)) == 0 &&
+                 header.version == FMC_AVAILABILITY_VERSION && header.entry_count <= MAX_ENTRIES;
+    if (valid) {
+        m_entries.resize(header.entry_count);
+        valid = header.entry_count == 0 || fread(m_entries.data(), sizeof(FMCAvailabilityEntry), header.entry_count, file) == header.entry_count;
+        valid = valid && PackChecksum(m_entries.data(), m_entries.size() * sizeof(FMCAvailabilityEntry)) == header.checksum;
+    }
+    fclose(file);
+
+    // A damaged or outdated cache is simply rebuilt
+    if (!valid) {
+        m_entries.clear();
+        return false;
+    }
+    for (const FMCAvailabilityEntry& entry : m_entries) {
+        if (entry.last_used > m_sequence) m_sequence = entry.last_used;
+    }
+    return true;
+}
+
+bool AvailabilityCache::SaveIfChanged(const char* path)
+{
+    if (!m_changed) return true;
+
+    FMCAvailabilityHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FMC_AVAILABILITY_MAGIC, sizeof(FMC_AVAILABILITY_MAGIC));
+    header.version = FMC_AVAILABILITY_VERSION;
+    header.entry_count = (uint32_t)m_entries.size();
+    header.checksum = PackChecksum(m_entries.data(), m_entries.size() * sizeof(FMCAvailabilityEntry));
+
+    // Written in place: an interrupted write fails the checksum and is treated as no cache
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !m_entries.empty()) {
+        ok = fwrite(m_entries.data(), sizeof(FMCAvailabilityEntry), m_entries.size(), file) == m_entries.size();
+    }
+    ok = (fclose(file) == 0) && ok;
+    if (ok) m_changed = false;
+    return ok;
+}
+
+const FMCAvailabilityEntry* AvailabilityCache::Find(uint64_t fingerprint) const
+{
+    for (const FMCAvailabilityEntry& entry : m_entries) {
+        if (entry.fingerprint == fingerprint) return &entry;
+    }
+    return nullptr;
+}
+
+void AvailabilityCache::Store(const FMCAvailabilityEntry& entry)
+{
+    FMCAvailabilityEntry* slot = nullptr;
+    for (FMCAvailabilityEntry& existing : m_entries) {
+        if (existing.fingerprint == entry.fingerprint) slot = &existing;
+    }
+    if (slot == nullptr && m_entries.size() >= MAX_ENTRIES) {
+        slot = &m_entries[0];
+        for (FMCAvailabilityEntry& existing : m_entries) {
+            if (existing.last_used < slot->last_used) slot = &existing;
+        }
+    }
+    if (slot == nullptr) {
+        m_entries.push_back(entry);
+        slot = &m_entries.back();
+    } else if (slot->fingerprint == entry.fingerprint && slot->profile_hash == entry.profile_hash &&
+               slot->available[0] == entry.available[0] && slot->available[1] == entry.available[1] &&
+               slot->last_used == m_sequence) {
+        return;   // Already the most recent entry, unchanged
+    } else {
+        *slot = entry;
+    }
+    slot->last_used = ++m_sequence;
+    m_changed = true;
+}
+
+void AvailabilityCache::Remove(uint64_t fingerprint)
+{
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        if (m_entries[i].fingerprint == fingerprint) {
+            m_entries.erase(m_entries.begin() + i);
+            m_changed = true;
+            return;
+        }
+    }
+}
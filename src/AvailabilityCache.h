@@ -0,0 +1,62 @@
+// Persistent command availability cache
+//
+// Remembers, per aircraft fingerprint, which profile was detected and which of its key
+// commands exist, in FMCKeyboard_commands.cache next to the plugin binary. When a known
+// aircraft loads again the plugin takes the profile and command table from here instead of
+// probing and resolving everything up front, then verifies both over the next frames.
+// All fields are little-endian (every supported platform is).
+
+#ifndef AVAILABILITY_CACHE_H
+#define AVAILABILITY_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#define FMC_AVAILABILITY_MAGIC "FMCKCAC"    // 7 characters + NUL fill the 8-byte magic field
+#define FMC_AVAILABILITY_VERSION 1
+#define FMC_AVAILABILITY_FILE "FMCKeyboard_commands.cache"
+
+struct FMCAvailabilityHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+    uint64_t checksum;          // FNV-1a 64 of the entries
+};
+
+struct FMCAvailabilityEntry {
+    uint64_t fingerprint;       // HashAircraftFingerprint of the aircraft
+    uint64_t profile_hash;      // ProfilePack::ProfileHash of the profile detected for it
+    uint64_t available[2];      // [side - 1]: bit ButtonId set = key command exists; bit 0 = minus command
+    uint64_t last_used;         // Store sequence number, for evicting the least recently used
+};
+
+static_assert(sizeof(FMCAvailabilityHeader) == 24, "FMCAvailabilityHeader layout is part of the file format");
+static_assert(sizeof(FMCAvailabilityEntry) == 40, "FMCAvailabilityEntry layout is part of the file format");
+
+class AvailabilityCache {
+public:
+    static const size_t MAX_ENTRIES = 64;
+
+    AvailabilityCache();
+
+    // Replace the contents with a cache file; false (and empty) if it is missing or invalid
+    bool Load(const char* path);
+    // Write the file if anything changed since the last Load/Save
+    bool SaveIfChanged(const char* path);
+
+    const FMCAvailabilityEntry* Find(uint64_t fingerprint) const;
+    // Add or update the entry for entry.fingerprint, evicting the least recently used if full
+    void Store(const FMCAvailabilityEntry& entry);
+    void Remove(uint64_t fingerprint);
+
+    size_t Size() const { return m_entries.size(); }
+
+private:
+    std::vector<FMCAvailabilityEntry> m_entries;
+    uint64_t m_sequence;
+    bool m_changed;
+};
+
+#endif // AVAILABILITY_CACHE_H
@@ -0,0 +1,314 @@
+// Built-in aircraft profiles
+//
+// The aircraft the plugin supports out of the box. Their command names are expanded and
+// validated at compile time; AppendBuiltinProfiles converts them to AircraftProfile for
+// the plugin and for the profile pack compiler.
+
+#include "AircraftProfile.h"
+#include "SessionRecording.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Per-aircraft key names, indexed by ButtonId (nullptr = key not supported by the aircraft).
+// The +/- buttons are not looked up here; they go through the aircraft's minus command.
+static constexpr const char* g_zibo_key_names[] = {
+    nullptr,
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+    "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M",
+    "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z",
+    "clr", "SP", "del", "ent", "slash", "period", "minus", nullptr
+};
+
+// Default aircraft (737/A330) use lowercase letters and long names for special keys
+static constexpr const char* g_default_fms_key_names[] = {
+    nullptr,
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+    "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m",
+    "n", "o", "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z",
+    "clear", "space", "delete", "enter", "slash", "period", "minus", nullptr
+};
+
+// SR22 GPS GCU uses uppercase letters and has no slash or minus functionality
+static constexpr const char* g_gcu478_key_names[] = {
+    nullptr,
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+    "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M",
+    "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z",
+    "clr", "spc", "bksp", "ent", nullptr, "dot", nullptr, nullptr
+};
+
+static_assert(sizeof(g_zibo_key_names) / sizeof(g_zibo_key_names[0]) == BUTTON_COUNT, "g_zibo_key_names must cover every ButtonId");
+static_assert(sizeof(g_default_fms_key_names) / sizeof(g_default_fms_key_names[0]) == BUTTON_COUNT, "g_default_fms_key_names must cover every ButtonId");
+static_assert(sizeof(g_gcu478_key_names) / sizeof(g_gcu478_key_names[0]) == BUTTON_COUNT, "g_gcu478_key_names must cover every ButtonId");
+
+// Built-in aircraft, compiled into the plugin. Profile files (AircraftProfile.h) can add
+// more aircraft or replace one of these by using the same name.
+struct AircraftConfig {
+    FMCSessionAircraft session_code; // Aircraft code stored in session recordings
+    const char* name;
+    const char* status_label;        // Status window text when the aircraft has a single FMC
+    const char* icao;
+    const char* require_command;     // Detection: command that must exist (nullptr = none)
+    int priority;                    // Detection: higher priority profiles are tried first
+    const char* command_format;      // Command format with %s for key name (single FMC)
+    const char* command_format_side; // For aircraft with side-specific commands (like ZIBO)
+    const char* command_format_capt; // Captain FMC command format (for FMS/FMS2 style)
+    const char* command_format_fo;   // First Officer FMC command format (for FMS/FMS2 style)
+    const char* minus_command;       // Specific minus command for +/- toggle
+    const char* minus_command_capt;  // Captain minus command (for FMS/FMS2 style)
+    const char* minus_command_fo;    // First Officer minus command (for FMS/FMS2 style)
+    const char* scratchpad_dataref;  // Scratchpad text dataref, %d for the FMC side (nullptr = none)
+    const char* const* key_names;    // Aircraft key names indexed by ButtonId
+    bool has_side_specific_fmc;      // Whether aircraft has separate Capt/FO FMCs
+    RepeatPolicy clr_repeat_policy;  // What auto-repeats of a held CLR do
+};
+
+// Supported aircraft configurations
+static constexpr AircraftConfig g_aircraft_configs[] = {
+    {
+        FMC_SESSION_AIRCRAFT_ZIBO_737,
+        "ZIBO 737",
+        "737",
+        "B738",
+        "laminar/B738/button/fmc1_0",      // ZIBO-specific command, absent on the default 737
+        10,                                // Tried before the default 737
+        nullptr,                           // Uses side-specific format
+        "laminar/B738/button/fmc%d_%s",   // Format with FMC side
+        nullptr,                           // No separate capt format
+        nullptr,                           // No separate fo format
+        "laminar/B738/button/fmc%d_minus", // Minus command format
+        nullptr,                           // No separate capt minus
+        nullptr,                           // No separate fo minus
+        "laminar/B738/fmc%d/Line_entry",  // Scratchpad text per FMC
+        g_zibo_key_names,                  // Original ZIBO key names
+        true,                              // Has side-specific FMCs
+        REPEAT_HOLD                        // A held CLR clears the whole scratchpad
+    },
+    {
+        FMC_SESSION_AIRCRAFT_DEFAULT_737,
+        "Default 737",
+        "737",
+        "B738",
+        nullptr,
+        0,
+        nullptr,                           // Uses capt/fo specific formats
+        nullptr,                           // No side-specific format
+        "sim/FMS/key_%s",                  // Captain FMS commands
+        "sim/FMS2/key_%s",                 // First Officer FMS commands
+        nullptr,                           // No single minus command
+        "sim/FMS/key_minus",              // Captain minus command
+        "sim/FMS2/key_minus",             // First Officer minus command
+        "sim/cockpit2/radios/indicators/fms_cdu%d_text_line13",   // Scratchpad: last CDU screen line
+        g_default_fms_key_names,           // Lowercase FMS key names
+        true,                              // Has side-specific FMCs
+        REPEAT_PASS                        // Every repeat is another CLR press
+    },
+    {
+        FMC_SESSION_AIRCRAFT_DEFAULT_A330,
+        "Default A330",
+        "330",
+        "A330",
+        nullptr,
+        0,
+        nullptr,                           // Uses capt/fo specific formats
+        nullptr,                           // No side-specific format
+        "sim/FMS/key_%s",                  // Captain FMS commands
+        "sim/FMS2/key_%s",                 // First Officer FMS commands
+        nullptr,                           // No single minus command
+        "sim/FMS/key_minus",              // Captain minus command
+        "sim/FMS2/key_minus",             // First Officer minus command
+        "sim/cockpit2/radios/indicators/fms_cdu%d_text_line13",   // Scratchpad: last MCDU screen line
+        g_default_fms_key_names,           // Lowercase FMS key names
+        true,                              // Has side-specific FMCs
+        REPEAT_PASS                        // Every repeat is another CLR press
+    },
+    {
+        FMC_SESSION_AIRCRAFT_DEFAULT_SR22,
+        "Default SR22",
+        "SR22",
+        "SR22",
+        nullptr,
+        0,
+        "sim/GPS/gcu478/%s",              // GPS GCU commands
+        nullptr,                           // No side-specific format
+        nullptr,                           // No capt format
+        nullptr,                           // No fo format
+        nullptr,                           // No plus/minus functionality
+        nullptr,                           // No capt minus
+        nullptr,                           // No fo minus
+        nullptr,                           // No +/-, so no scratchpad to read
+        g_gcu478_key_names,                // GPS GCU key names
+        false,                             // Single GPS system
+        REPEAT_PASS                        // Every repeat is another CLR press
+    }
+};
+
+static constexpr size_t AIRCRAFT_CONFIG_COUNT = sizeof(g_aircraft_configs) / sizeof(g_aircraft_configs[0]);
+
+// Compile-time command name generation.
+// Every (aircraft, side, button) command name of the built-in aircraft is expanded from
+// g_aircraft_configs at compile time; profile files are expanded once when they are loaded.
+// Either way the runtime never formats a string.
+struct CommandNameTable {
+    AircraftCommandNames aircraft[AIRCRAFT_CONFIG_COUNT];   // Same order as g_aircraft_configs
+};
+
+// Key command format for a side (same selection order the runtime used with snprintf)
+static constexpr const char* KeyCommandFormat(const AircraftConfig& config, int side)
+{
+    if (config.command_format_capt && config.command_format_fo) {
+        // Aircraft with separate Capt/FO formats (like default 737/A330)
+        return (side == 1) ? config.command_format_capt : config.command_format_fo;
+    }
+    if (config.has_side_specific_fmc && config.command_format_side) {
+        // Aircraft with side-specific FMCs (like ZIBO)
+        return config.command_format_side;
+    }
+    // Aircraft with single FMC system (like SR22)
+    return config.command_format;
+}
+
+// +/- toggle command format for a side, or nullptr if the aircraft has none (e.g., SR22)
+static constexpr const char* MinusCommandFormat(const AircraftConfig& config, int side)
+{
+    if (config.minus_command_capt && config.minus_command_fo) {
+        // Aircraft with separate Capt/FO minus commands (like default 737/A330)
+        return (side == 1) ? config.minus_command_capt : config.minus_command_fo;
+    }
+    return config.minus_command;
+}
+
+static constexpr CommandNameTable MakeCommandNameTable()
+{
+    CommandNameTable table = {};
+    for (size_t a = 0; a < AIRCRAFT_CONFIG_COUNT; a++) {
+        const AircraftConfig& config = g_aircraft_configs[a];
+        int side_count = config.has_side_specific_fmc ? 2 : 1;
+        for (int side = 1; side <= side_count; side++) {
+            const char* key_format = KeyCommandFormat(config, side);
+            for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+                // +/- keys go through the minus command, see HandlePlusMinusKey
+                if (button == BUTTON_MINUS || button == BUTTON_PLUS) continue;
+                const char* key_name = config.key_names[button];
+                if (key_format && key_name) {
+                    table.aircraft[a].keys[side - 1][button] = FormatCommandName(key_format, side, key_name);
+                }
+            }
+            const char* minus_format = MinusCommandFormat(config, side);
+            if (minus_format) {
+                table.aircraft[a].minus[side - 1] = FormatCommandName(minus_format, side, "");
+            }
+            if (config.scratchpad_dataref) {
+                table.aircraft[a].scratchpad[side - 1] = FormatCommandName(config.scratchpad_dataref, side, "");
+            }
+        }
+    }
+    return table;
+}
+
+// Compile-time validation of the config formats against the data they are expanded with
+static constexpr bool CommandFormatsAreValid()
+{
+    for (size_t a = 0; a < AIRCRAFT_CONFIG_COUNT; a++) {
+        const AircraftConfig& config = g_aircraft_configs[a];
+        int side_count = config.has_side_specific_fmc ? 2 : 1;
+        for (int side = 1; side <= side_count; side++) {
+            const char* key_format = KeyCommandFormat(config, side);
+            if (!key_format) return false;
+            // Exactly one key name; a side number only where the format is shared by both sides
+            if (CountConversions(key_format, 's') != 1) return false;
+            int expected_sides = (key_format == config.command_format_side) ? 1 : 0;
+            if (CountConversions(key_format, 'd') != expected_sides) return false;
+            
+            const char* minus_format = MinusCommandFormat(config, side);
+            if (minus_format) {
+                if (CountConversions(minus_format, 's') != 0) return false;
+                int minus_sides = CountConversions(minus_format, 'd');
+                if (minus_sides < 0 || minus_sides > 1) return false;
+                if (minus_sides == 1 && !config.has_side_specific_fmc) return false;
+                if (ConstexprLength(minus_format) >= COMMAND_NAME_SIZE) return false;
+            }
+        }
+        if (config.scratchpad_dataref) {
+            if (CountConversions(config.scratchpad_dataref, 's') != 0) return false;
+            if (CountConversions(config.scratchpad_dataref, 'd') != (config.has_side_specific_fmc ? 1 : 0)) return false;
+            if (ConstexprLength(config.scratchpad_dataref) >= COMMAND_NAME_SIZE) return false;
+        }
+    }
+    return true;
+}
+
+static constexpr bool KeyNamesAreValid()
+{
+    for (size_t a = 0; a < AIRCRAFT_CONFIG_COUNT; a++) {
+        const AircraftConfig& config = g_aircraft_configs[a];
+        const char* key_format = KeyCommandFormat(config, 1);
+        for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+            const char* key_name = config.key_names[button];
+            if (!key_name) continue;
+            if (key_name[0] == '\0') return false;
+            for (size_t i = 0; key_name[i] != '\0'; i++) {
+                if (key_name[i] == '%' || key_name[i] == ' ') return false;
+            }
+            // Room for the expanded name: format minus its conversions plus the key and side digit
+            if (key_format && ConstexprLength(key_format) + ConstexprLength(key_name) >= COMMAND_NAME_SIZE) return false;
+        }
+    }
+    return true;
+}
+
+static_assert(CommandFormatsAreValid(), "g_aircraft_configs command formats must match their %d/%s arguments");
+static_assert(KeyNamesAreValid(), "Aircraft key names must be non-empty, contain no '%' or spaces and fit COMMAND_NAME_SIZE");
+
+static constexpr CommandNameTable g_command_names = MakeCommandNameTable();
+
+static constexpr bool ConstexprEquals(const char* a, const char* b)
+{
+    size_t i = 0;
+    while (a[i] != '\0' && a[i] == b[i]) i++;
+    return a[i] == b[i];
+}
+
+// Spot checks of the generated names against the formats documented in the README
+static_assert(ConstexprEquals(g_command_names.aircraft[0].keys[1][BUTTON_A].text, "laminar/B738/button/fmc2_A"), "ZIBO command name expansion");
+static_assert(ConstexprEquals(g_command_names.aircraft[0].minus[0].text, "laminar/B738/button/fmc1_minus"), "ZIBO minus command expansion");
+static_assert(ConstexprEquals(g_command_names.aircraft[1].keys[1][BUTTON_CLR].text, "sim/FMS2/key_clear"), "Default FMS command name expansion");
+static_assert(ConstexprEquals(g_command_names.aircraft[0].scratchpad[1].text, "laminar/B738/fmc2/Line_entry"), "ZIBO scratchpad dataref expansion");
+static_assert(ConstexprEquals(g_command_names.aircraft[3].keys[0][BUTTON_SP].text, "sim/GPS/gcu478/spc"), "SR22 GCU command name expansion");
+static_assert(g_command_names.aircraft[3].keys[0][BUTTON_SLASH].text[0] == '\0', "SR22 has no slash command");
+
+// Convert a built-in aircraft to a profile; its command names were expanded at compile time
+static AircraftProfile MakeBuiltinProfile(size_t index)
+{
+    const AircraftConfig& config = g_aircraft_configs[index];
+    AircraftProfile profile;
+    memset(&profile, 0, sizeof(profile));
+    snprintf(profile.name, sizeof(profile.name), "%s", config.name);
+    snprintf(profile.status_label, sizeof(profile.status_label), "%s", config.status_label);
+    snprintf(profile.icao[0], sizeof(profile.icao[0]), "%s", config.icao);
+    profile.icao_count = 1;
+    if (config.require_command) {
+        snprintf(profile.require_commands[0].text, sizeof(profile.require_commands[0].text), "%s", config.require_command);
+        profile.require_count = 1;
+    }
+    profile.priority = config.priority;
+    profile.has_side_specific_fmc = config.has_side_specific_fmc;
+    bool has_minus_command = config.minus_command || config.minus_command_capt || config.minus_command_fo;
+    profile.plus_minus = has_minus_command ? PLUS_MINUS_TOGGLE : PLUS_MINUS_NONE;
+    profile.session_code = (uint8_t)config.session_code;
+    profile.commands = g_command_names.aircraft[index];
+    for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+        profile.repeat_policy[button] = DefaultRepeatPolicy((ButtonId)button);
+    }
+    profile.repeat_policy[BUTTON_CLR] = config.clr_repeat_policy;
+    return profile;
+}
+
+
+void AppendBuiltinProfiles(std::vector<AircraftProfile>* profiles)
+{
+    for (size_t i = 0; i < AIRCRAFT_CONFIG_COUNT; i++) {
+        profiles->push_back(MakeBuiltinProfile(i));
+    }
+}
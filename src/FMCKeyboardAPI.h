@@ -0,0 +1,44 @@
+// Universal FMC Keyboard Input - inter-plugin API
+//
+// Other plugins can type text into the active aircraft's FMC with a single message
+// instead of finding and firing one command per character:
+//
+//     FMCKeyboardTextMessage msg;
+//     memset(&msg, 0, sizeof(msg));
+//     msg.structSize = sizeof(msg);
+//     msg.side = FMC_KEYBOARD_SIDE_CAPTAIN;
+//     msg.text = "KSEA/KPDX";
+//     msg.length = -1;
+//     XPLMPluginID fmc_keyboard = XPLMFindPluginBySignature(FMC_KEYBOARD_PLUGIN_SIGNATURE);
+//     if (fmc_keyboard != XPLM_NO_PLUGIN_ID) {
+//         XPLMSendMessageToPlugin(fmc_keyboard, FMC_KEYBOARD_MSG_TYPE_TEXT, &msg);
+//     }
+//
+// The message is handled synchronously; outAccepted/outRejected are filled in before
+// XPLMSendMessageToPlugin returns. Accepted characters are queued and sent to the FMC
+// at the plugin's paced rate (Universal/FMC_Keyboard/queue/commands_per_frame).
+// Keyboard input does not need to be toggled on, but a supported aircraft must be loaded.
+
+#ifndef FMC_KEYBOARD_API_H
+#define FMC_KEYBOARD_API_H
+
+#define FMC_KEYBOARD_PLUGIN_SIGNATURE "justin.universal.fmc.keyboard"
+
+// Message IDs below 0x00FFFFFF are reserved for X-Plane and the plugin SDK
+#define FMC_KEYBOARD_MSG_TYPE_TEXT 0x464D4301   // "FMC" + 1; inParam is an FMCKeyboardTextMessage*
+
+#define FMC_KEYBOARD_SIDE_ACTIVE  0   // Side currently selected by the toggle commands
+#define FMC_KEYBOARD_SIDE_CAPTAIN 1
+#define FMC_KEYBOARD_SIDE_FO      2   // Same as Captain on single-FMC aircraft (SR22)
+
+typedef struct {
+    int structSize;      // Set to sizeof(FMCKeyboardTextMessage)
+    int side;            // FMC_KEYBOARD_SIDE_*
+    const char* text;    // ASCII or UTF-8 text. Letters are case-insensitive; space, '/', '.',
+                         // '-', '+' and '\n' (ENTER) are supported where the aircraft has the key
+    int length;          // Number of bytes in text, or -1 if NUL-terminated
+    int outAccepted;     // Filled by the plugin: characters queued for the FMC
+    int outRejected;     // Filled by the plugin: characters with no key on this aircraft, or queue full
+} FMCKeyboardTextMessage;
+
+#endif // FMC_KEYBOARD_API_H
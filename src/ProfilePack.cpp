@@ -0,0 +1,562 @@
+// Precompiled aircraft profile pack (see ProfilePack.h)
+
+#include "ProfilePack.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static void SetPackError(char* error, size_t error_size, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error, error_size, format, args);
+    va_end(args);
+}
+
+static uint32_t AlignSection(size_t offset)
+{
+    return (uint32_t)((offset + 7) & ~(size_t)7);
+}
+
+bool GetProfileSourceStamp(const char* path, int64_t* size, int64_t* modified)
+{
+    struct stat info;
+    if (stat(path, &info) != 0) return false;
+    *size = (int64_t)info.st_size;
+    *modified = (int64_t)info.st_mtime;
+    return true;
+}
+
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+// Continue an FNV-1a hash with more bytes
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t PackChecksum(const void* data, size_t size)
+{
+    return HashBytes(FNV_OFFSET_BASIS, data, size);
+}
+
+static uint64_t HashString(uint64_t hash, const char* text)
+{
+    return HashBytes(hash, text, strlen(text) + 1);
+}
+
+uint64_t PackIcaoCode(const char* icao)
+{
+    size_t length = strlen(icao);
+    if (length == 0 || length >= sizeof(uint64_t)) return 0;
+    uint64_t code = 0;
+    for (size_t i = 0; i < length; i++) {
+        code |= (uint64_t)(uint8_t)icao[i] << (8 * i);
+    }
+    return code;
+}
+
+uint64_t HashAcfFileName(const char* file_name)
+{
+    if (file_name[0] == '\0') return 0;
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; file_name[i] != '\0'; i++) {
+        hash ^= (uint8_t)tolower((unsigned char)file_name[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t HashAircraftFingerprint(const AircraftFingerprint& fingerprint)
+{
+    uint64_t keys[2] = {fingerprint.icao, fingerprint.acf_file};
+    uint64_t hash = HashBytes(FNV_OFFSET_BASIS, keys, sizeof(keys));
+    hash = HashString(hash, fingerprint.acf_path);
+    hash = HashString(hash, fingerprint.author);
+    return HashString(hash, fingerprint.studio);
+}
+
+// Bucket of a fingerprint key in a table of bucket_count (a power of two) buckets
+static uint32_t MatchBucket(uint64_t key, uint32_t kind, uint32_t bucket_count)
+{
+    uint64_t mixed = (key ^ ((uint64_t)kind << 56)) * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(mixed >> 32) & (bucket_count - 1);
+}
+
+uint64_t HashAircraftProfiles(const std::vector<AircraftProfile>& profiles)
+{
+    // Field by field, so struct padding never affects the result
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (const AircraftProfile& profile : profiles) {
+        hash = HashString(hash, profile.name);
+        hash = HashString(hash, profile.status_label);
+        for (int i = 0; i < profile.icao_count; i++) hash = HashString(hash, profile.icao[i]);
+        for (int i = 0; i < profile.acf_file_count; i++) hash = HashString(hash, profile.acf_files[i]);
+        hash = HashString(hash, profile.author);
+        hash = HashString(hash, profile.studio);
+        for (int i = 0; i < profile.require_count; i++) hash = HashString(hash, profile.require_commands[i].text);
+        for (int i = 0; i < profile.reject_count; i++) hash = HashString(hash, profile.reject_commands[i].text);
+        int32_t scalars[10] = {profile.icao_count, profile.acf_file_count, profile.require_count, profile.reject_count,
+                               profile.priority, profile.has_side_specific_fmc ? 1 : 0,
+                               (int32_t)profile.plus_minus, (int32_t)profile.session_code, profile.scratchpad_write ? 1 : 0,
+                               (int32_t)profile.scratchpad_size};
+        hash = HashBytes(hash, scalars, sizeof(scalars));
+        for (int side = 0; side < 2; side++) {
+            for (int button = 0; button < BUTTON_COUNT; button++) {
+                hash = HashString(hash, profile.commands.keys[side][button].text);
+            }
+            hash = HashString(hash, profile.commands.minus[side].text);
+            hash = HashString(hash, profile.commands.scratchpad[side].text);
+        }
+        hash = HashBytes(hash, profile.repeat_policy, sizeof(profile.repeat_policy));
+        hash = HashBytes(hash, profile.repeat_rate, sizeof(profile.repeat_rate));
+    }
+    return hash;
+}
+
+// String pool with de-duplication; offset 0 is the empty string
+class StringPoolBuilder {
+public:
+    StringPoolBuilder() : m_data(1, '\0') {}
+
+    uint32_t Add(const char* text)
+    {
+        if (text[0] == '\0') return 0;
+        std::unordered_map<std::string, uint32_t>::const_iterator found = m_offsets.find(text);
+        if (found != m_offsets.end()) return found->second;
+        uint32_t offset = (uint32_t)m_data.size();
+        m_data.insert(m_data.end(), text, text + strlen(text) + 1);
+        m_offsets.emplace(text, offset);
+        return offset;
+    }
+
+    const std::vector<char>& Data() const { return m_data; }
+
+private:
+    std::vector<char> m_data;
+    std::unordered_map<std::string, uint32_t> m_offsets;
+};
+
+bool BuildProfilePack(const std::vector<AircraftProfile>& profiles, const std::vector<ProfileSourceStamp>& sources,
+                      uint64_t builtin_hash, std::vector<uint8_t>* out, char* error, size_t error_size)
+{
+    StringPoolBuilder strings;
+
+    std::vector<FMCPackProfile> packed(profiles.size());
+    std::vector<FMCPackMatchKey> matches;
+    for (size_t i = 0; i < profiles.size(); i++) {
+        const AircraftProfile& profile = profiles[i];
+        FMCPackProfile& entry = packed[i];
+        memset(&entry, 0, sizeof(entry));
+        entry.name = strings.Add(profile.name);
+        entry.status_label = strings.Add(profile.status_label);
+        entry.author = strings.Add(profile.author);
+        entry.studio = strings.Add(profile.studio);
+        for (int k = 0; k < profile.require_count; k++) entry.require_commands[k] = strings.Add(profile.require_commands[k].text);
+        for (int k = 0; k < profile.reject_count; k++) entry.reject_commands[k] = strings.Add(profile.reject_commands[k].text);
+        entry.priority = profile.priority;
+        entry.has_side_specific_fmc = profile.has_side_specific_fmc ? 1 : 0;
+        entry.plus_minus = (uint8_t)profile.plus_minus;
+        entry.session_code = profile.session_code;
+        entry.scratchpad_write = profile.scratchpad_write ? 1 : 0;
+        entry.scratchpad_size = profile.scratchpad_size;
+        for (int side = 0; side < 2; side++) {
+            for (int button = 0; button < BUTTON_COUNT; button++) {
+                entry.key_commands[side][button] = strings.Add(profile.commands.keys[side][button].text);
+            }
+            entry.minus_commands[side] = strings.Add(profile.commands.minus[side].text);
+            entry.scratchpad_datarefs[side] = strings.Add(profile.commands.scratchpad[side].text);
+        }
+        for (int button = 0; button < BUTTON_COUNT; button++) {
+            entry.repeat_policy[button] = (uint8_t)profile.repeat_policy[button];
+            entry.repeat_rate[button] = profile.repeat_rate[button];
+        }
+
+        FMCPackMatchKey match;
+        memset(&match, 0, sizeof(match));
+        match.profile = (uint32_t)i;
+        for (int k = 0; k < profile.icao_count; k++) {
+            match.key = PackIcaoCode(profile.icao[k]);
+            match.kind = FINGERPRINT_KEY_ICAO;
+            if (match.key == 0) {
+                SetPackError(error, error_size, "profile \"%s\": invalid ICAO code '%s'", profile.name, profile.icao[k]);
+                return false;
+            }
+            matches.push_back(match);
+        }
+        for (int k = 0; k < profile.acf_file_count; k++) {
+            match.key = HashAcfFileName(profile.acf_files[k]);
+            match.kind = FINGERPRINT_KEY_ACF_FILE;
+            matches.push_back(match);
+        }
+        entry.match_keys = (profile.icao_count > 0 ? FINGERPRINT_KEY_ICAO : 0) |
+                           (profile.acf_file_count > 0 ? FINGERPRINT_KEY_ACF_FILE : 0);
+    }
+
+    // Hash index: about one key per bucket, each bucket's keys in detection order
+    uint32_t bucket_count = 1;
+    while (bucket_count < matches.size()) bucket_count *= 2;
+    std::sort(matches.begin(), matches.end(), [bucket_count](const FMCPackMatchKey& a, const FMCPackMatchKey& b) {
+        uint32_t bucket_a = MatchBucket(a.key, a.kind, bucket_count);
+        uint32_t bucket_b = MatchBucket(b.key, b.kind, bucket_count);
+        if (bucket_a != bucket_b) return bucket_a < bucket_b;
+        if (a.profile != b.profile) return a.profile < b.profile;
+        if (a.kind != b.kind) return a.kind < b.kind;
+        return a.key < b.key;
+    });
+    matches.erase(std::unique(matches.begin(), matches.end(), [](const FMCPackMatchKey& a, const FMCPackMatchKey& b) {
+        return a.key == b.key && a.kind == b.kind && a.profile == b.profile;
+    }), matches.end());
+    std::vector<FMCPackBucket> buckets(bucket_count);
+    memset(buckets.data(), 0, buckets.size() * sizeof(FMCPackBucket));
+    for (size_t i = 0; i < matches.size(); i++) {
+        FMCPackBucket& bucket = buckets[MatchBucket(matches[i].key, matches[i].kind, bucket_count)];
+        if (bucket.count == 0) bucket.first = (uint32_t)i;
+        bucket.count++;
+    }
+
+    std::vector<ProfileSourceStamp> sorted_sources = sources;
+    std::sort(sorted_sources.begin(), sorted_sources.end(), [](const ProfileSourceStamp& a, const ProfileSourceStamp& b) {
+        return a.name < b.name;
+    });
+    std::vector<FMCPackSource> packed_sources(sorted_sources.size());
+    for (size_t i = 0; i < sorted_sources.size(); i++) {
+        memset(&packed_sources[i], 0, sizeof(packed_sources[i]));
+        packed_sources[i].name = strings.Add(sorted_sources[i].name.c_str());
+        packed_sources[i].size = sorted_sources[i].size;
+        packed_sources[i].modified = sorted_sources[i].modified;
+    }
+
+    FMCPackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FMC_PROFILE_PACK_MAGIC, sizeof(FMC_PROFILE_PACK_MAGIC));
+    header.version = FMC_PROFILE_PACK_VERSION;
+    header.header_size = sizeof(FMCPackHeader);
+    header.builtin_hash = builtin_hash;
+    header.profile_count = (uint32_t)packed.size();
+    header.profile_offset = AlignSection(sizeof(FMCPackHeader));
+    header.bucket_count = bucket_count;
+    header.bucket_offset = AlignSection(header.profile_offset + packed.size() * sizeof(FMCPackProfile));
+    header.match_count = (uint32_t)matches.size();
+    header.match_offset = AlignSection(header.bucket_offset + buckets.size() * sizeof(FMCPackBucket));
+    header.source_count = (uint32_t)packed_sources.size();
+    header.source_offset = AlignSection(header.match_offset + matches.size() * sizeof(FMCPackMatchKey));
+    header.string_offset = AlignSection(header.source_offset + packed_sources.size() * sizeof(FMCPackSource));
+    header.string_size = (uint32_t)strings.Data().size();
+    size_t file_size = (size_t)header.string_offset + header.string_size;
+    if (file_size > 0x7FFFFFFF) {
+        SetPackError(error, error_size, "pack would be %zu bytes, too large", file_size);
+        return false;
+    }
+    header.file_size = (uint32_t)file_size;
+
+    out->assign(file_size, 0);
+    uint8_t* data = out->data();
+    if (!packed.empty()) memcpy(data + header.profile_offset, packed.data(), packed.size() * sizeof(FMCPackProfile));
+    memcpy(data + header.bucket_offset, buckets.data(), buckets.size() * sizeof(FMCPackBucket));
+    if (!matches.empty()) memcpy(data + header.match_offset, matches.data(), matches.size() * sizeof(FMCPackMatchKey));
+    if (!packed_sources.empty()) memcpy(data + header.source_offset, packed_sources.data(), packed_sources.size() * sizeof(FMCPackSource));
+    memcpy(data + header.string_offset, strings.Data().data(), header.string_size);
+    header.checksum = PackChecksum(data + sizeof(FMCPackHeader), file_size - sizeof(FMCPackHeader));
+    memcpy(data, &header, sizeof(header));
+    return true;
+}
+
+ProfilePack::ProfilePack()
+    : m_header(nullptr), m_profiles(nullptr), m_buckets(nullptr), m_matches(nullptr), m_sources(nullptr), m_strings(nullptr)
+{
+}
+
+// A section of count entries must lie inside the file, after the header, 8-byte aligned
+static bool SectionIsValid(uint32_t offset, uint32_t count, size_t entry_size, size_t file_size)
+{
+    if (offset % 8 != 0 || offset < sizeof(FMCPackHeader)) return false;
+    return (uint64_t)offset + (uint64_t)count * entry_size <= file_size;
+}
+
+bool ProfilePack::Open(const uint8_t* data, size_t size, char* error, size_t error_size)
+{
+    Close();
+    if (data == nullptr || size < sizeof(FMCPackHeader)) {
+        SetPackError(error, error_size, "file is too small");
+        return false;
+    }
+    const FMCPackHeader* header = (const FMCPackHeader*)data;
+    if (memcmp(header->magic, FMC_PROFILE_PACK_MAGIC, sizeof(FMC_PROFILE_PACK_MAGIC)) != 0) {
+        SetPackError(error, error_size, "not a profile pack");
+        return false;
+    }
+    if (header->version != FMC_PROFILE_PACK_VERSION || header->header_size != sizeof(FMCPackHeader)) {
+        SetPackError(error, error_size, "unsupported pack version %u", header->version);
+        return false;
+    }
+    if (header->file_size != size) {
+        SetPackError(error, error_size, "file is truncated");
+        return false;
+    }
+    if (PackChecksum(data + sizeof(FMCPackHeader), size - sizeof(FMCPackHeader)) != header->checksum) {
+        SetPackError(error, error_size, "checksum mismatch");
+        return false;
+    }
+    if (!SectionIsValid(header->profile_offset, header->profile_count, sizeof(FMCPackProfile), size) ||
+        !SectionIsValid(header->bucket_offset, header->bucket_count, sizeof(FMCPackBucket), size) ||
+        !SectionIsValid(header->match_offset, header->match_count, sizeof(FMCPackMatchKey), size) ||
+        !SectionIsValid(header->source_offset, header->source_count, sizeof(FMCPackSource), size) ||
+        !SectionIsValid(header->string_offset, header->string_size, 1, size) ||
+        header->string_size == 0 || header->bucket_count == 0 || (header->bucket_count & (header->bucket_count - 1)) != 0) {
+        SetPackError(error, error_size, "section out of bounds");
+        return false;
+    }
+
+    const FMCPackProfile* profiles = (const FMCPackProfile*)(data + header->profile_offset);
+    const FMCPackBucket* buckets = (const FMCPackBucket*)(data + header->bucket_offset);
+    const FMCPackMatchKey* matches = (const FMCPackMatchKey*)(data + header->match_offset);
+    const FMCPackSource* sources = (const FMCPackSource*)(data + header->source_offset);
+    const char* strings = (const char*)(data + header->string_offset);
+    uint32_t string_size = header->string_size;
+    if (strings[0] != '\0' || strings[string_size - 1] != '\0') {
+        SetPackError(error, error_size, "malformed string pool");
+        return false;
+    }
+
+    // Check every string reference once, so lookups never need to
+    for (uint32_t i = 0; i < header->profile_count; i++) {
+        const FMCPackProfile& profile = profiles[i];
+        bool valid = profile.name < string_size && profile.status_label < string_size &&
+                     profile.author < string_size && profile.studio < string_size &&
+                     profile.minus_commands[0] < string_size && profile.minus_commands[1] < string_size &&
+                     profile.scratchpad_datarefs[0] < string_size && profile.scratchpad_datarefs[1] < string_size &&
+                     profile.plus_minus <= PLUS_MINUS_KEYS && profile.scratchpad_write <= 1 && profile.match_keys != 0 &&
+                     profile.match_keys <= (FINGERPRINT_KEY_ICAO | FINGERPRINT_KEY_ACF_FILE);
+        for (int k = 0; k < PROFILE_MAX_PROBES && valid; k++) {
+            valid = profile.require_commands[k] < string_size && profile.reject_commands[k] < string_size;
+        }
+        for (int side = 0; side < 2 && valid; side++) {
+            for (int button = 0; button < BUTTON_COUNT && valid; button++) {
+                valid = profile.key_commands[side][button] < string_size;
+            }
+        }
+        for (int button = 0; button < BUTTON_COUNT && valid; button++) {
+            valid = profile.repeat_policy[button] <= REPEAT_HOLD &&
+                    (profile.repeat_policy[button] != REPEAT_RATE_LIMIT || profile.repeat_rate[button] >= 1);
+        }
+        if (!valid) {
+            SetPackError(error, error_size, "malformed profile %u", i);
+            return false;
+        }
+    }
+    // Every key must sit in its own bucket, so lookups can trust the bucket ranges
+    for (uint32_t b = 0; b < header->bucket_count; b++) {
+        const FMCPackBucket& bucket = buckets[b];
+        bool valid = (uint64_t)bucket.first + bucket.count <= header->match_count;
+        for (uint32_t i = bucket.first; i < bucket.first + bucket.count && valid; i++) {
+            valid = matches[i].profile < header->profile_count &&
+                    MatchBucket(matches[i].key, matches[i].kind, header->bucket_count) == b &&
+                    (i == bucket.first || matches[i - 1].profile <= matches[i].profile);
+        }
+        if (!valid) {
+            SetPackError(error, error_size, "malformed match index");
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->source_count; i++) {
+        if (sources[i].name >= string_size) {
+            SetPackError(error, error_size, "malformed source list");
+            return false;
+        }
+    }
+
+    m_header = header;
+    m_profiles = profiles;
+    m_buckets = buckets;
+    m_matches = matches;
+    m_sources = sources;
+    m_strings = strings;
+    return true;
+}
+
+void ProfilePack::Close()
+{
+    m_header = nullptr;
+    m_profiles = nullptr;
+    m_buckets = nullptr;
+    m_matches = nullptr;
+    m_sources = nullptr;
+    m_strings = nullptr;
+}
+
+// True if text contains part, ignoring ASCII case; an empty part is in every text
+static bool ContainsIgnoringCase(const char* text, const char* part)
+{
+    size_t part_length = strlen(part);
+    for (const char* start = text; ; start++) {
+        size_t i = 0;
+        while (i < part_length && tolower((unsigned char)start[i]) == tolower((unsigned char)part[i])) i++;
+        if (i == part_length) return true;
+        if (*start == '\0') return false;
+    }
+}
+
+// Candidate profile for a fingerprint and the keys it matched
+struct ProfileCandidate {
+    uint32_t profile;
+    uint32_t matched_keys;
+};
+
+uint32_t ProfilePack::FindProfiles(const AircraftFingerprint& fingerprint, uint32_t* outProfiles, uint32_t max_profiles) const
+{
+    ProfileCandidate candidates[MAX_CANDIDATES];
+    uint32_t candidate_count = 0;
+
+    struct { uint64_t key; uint32_t kind; } lookups[] = {
+        {fingerprint.icao, FINGERPRINT_KEY_ICAO},
+        {fingerprint.acf_file, FINGERPRINT_KEY_ACF_FILE},
+    };
+    for (size_t l = 0; l < sizeof(lookups) / sizeof(lookups[0]); l++) {
+        if (lookups[l].key == 0) continue;
+        const FMCPackBucket& bucket = m_buckets[MatchBucket(lookups[l].key, lookups[l].kind, m_header->bucket_count)];
+        for (uint32_t i = bucket.first; i < bucket.first + bucket.count; i++) {
+            const FMCPackMatchKey& match = m_matches[i];
+            if (match.key != lookups[l].key || match.kind != lookups[l].kind) continue;
+            uint32_t c = 0;
+            while (c < candidate_count && candidates[c].profile != match.profile) c++;
+            if (c == candidate_count) {
+                if (candidate_count == MAX_CANDIDATES) continue;
+                candidates[candidate_count].profile = match.profile;
+                candidates[candidate_count].matched_keys = 0;
+                candidate_count++;
+            }
+            candidates[c].matched_keys |= match.kind;
+        }
+    }
+    std::sort(candidates, candidates + candidate_count, [](const ProfileCandidate& a, const ProfileCandidate& b) {
+        return a.profile < b.profile;
+    });
+
+    uint32_t count = 0;
+    for (uint32_t c = 0; c < candidate_count && count < max_profiles; c++) {
+        const FMCPackProfile& profile = m_profiles[candidates[c].profile];
+        if ((profile.match_keys & candidates[c].matched_keys) != profile.match_keys) continue;
+        if (!ContainsIgnoringCase(fingerprint.author, m_strings + profile.author)) continue;
+        if (!ContainsIgnoringCase(fingerprint.studio, m_strings + profile.studio)) continue;
+        outProfiles[count++] = candidates[c].profile;
+    }
+    return count;
+}
+
+uint64_t ProfilePack::ProfileHash(uint32_t index) const
+{
+    const FMCPackProfile& profile = m_profiles[index];
+    uint64_t hash = HashString(FNV_OFFSET_BASIS, String(profile.name));
+    for (int k = 0; k < PROFILE_MAX_PROBES; k++) {
+        hash = HashString(hash, String(profile.require_commands[k]));
+        hash = HashString(hash, String(profile.reject_commands[k]));
+    }
+    uint8_t flags[2] = {profile.has_side_specific_fmc, profile.plus_minus};
+    hash = HashBytes(hash, flags, sizeof(flags));
+    for (int side = 0; side < 2; side++) {
+        for (int button = 0; button < BUTTON_COUNT; button++) {
+            hash = HashString(hash, String(profile.key_commands[side][button]));
+        }
+        hash = HashString(hash, String(profile.minus_commands[side]));
+    }
+    return hash;
+}
+
+bool ProfilePack::MatchesSource(const char* name, int64_t size, int64_t modified) const
+{
+    const FMCPackSource* begin = m_sources;
+    const FMCPackSource* end = m_sources + m_header->source_count;
+    const FMCPackSource* found = std::lower_bound(begin, end, name, [this](const FMCPackSource& source, const char* value) {
+        return strcmp(m_strings + source.name, value) < 0;
+    });
+    return found != end && strcmp(m_strings + found->name, name) == 0 && found->size == size && found->modified == modified;
+}
+
+MappedFile::MappedFile()
+    : m_data(nullptr), m_size(0)
+#if defined(_WIN32)
+    , m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const char* path)
+{
+    Close();
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (view == NULL) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m_file = file;
+    m_mapping = mapping;
+    m_data = (const uint8_t*)view;
+    m_size = (size_t)size.QuadPart;
+#else
+    int file = open(path, O_RDONLY);
+    if (file < 0) return false;
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        close(file);
+        return false;
+    }
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);   // The mapping keeps the file referenced
+    if (view == MAP_FAILED) return false;
+    m_data = (const uint8_t*)view;
+    m_size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data == nullptr) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+    m_file = INVALID_HANDLE_VALUE;
+    m_mapping = NULL;
+#else
+    munmap((void*)m_data, m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
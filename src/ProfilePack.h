@@ -0,0 +1,206 @@
+// Precompiled aircraft profile pack
+//
+// tools/profile_pack/fmc_profile_pack compiles the built-in aircraft and every profiles/*.profile
+// file into profiles/profiles.pack: profiles already in detection order, with every command
+// name expanded into a shared string pool and a hash index from aircraft fingerprint keys
+// (packed ICAO code, .acf file name) to profiles, so detection cost does not grow with the
+// number of profiles. The plugin maps the file read-only and uses it in place. A pack is only
+// used if its checksum, version, built-in aircraft and source file stamps (name, size,
+// modification time) all match; otherwise the plugin parses the text files and builds the
+// same structure in memory. All fields are little-endian (every supported platform is).
+
+#ifndef PROFILE_PACK_H
+#define PROFILE_PACK_H
+
+#include "AircraftProfile.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#define FMC_PROFILE_PACK_MAGIC "FMCKPAK"     // 7 characters + NUL fill the 8-byte magic field
+#define FMC_PROFILE_PACK_VERSION 6
+#define FMC_PROFILE_PACK_FILE "profiles.pack"
+
+// Sections follow the header in this order, each starting on an 8-byte boundary
+struct FMCPackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;         // sizeof(FMCPackHeader) of the writer
+    uint64_t checksum;            // FNV-1a 64 of everything after the header
+    uint64_t builtin_hash;        // HashAircraftProfiles of the built-in aircraft it was compiled with
+    uint32_t file_size;
+    uint32_t profile_count;
+    uint32_t profile_offset;      // FMCPackProfile[profile_count], in detection order
+    uint32_t bucket_count;        // Power of two
+    uint32_t bucket_offset;       // FMCPackBucket[bucket_count]
+    uint32_t match_count;
+    uint32_t match_offset;        // FMCPackMatchKey[match_count], grouped by bucket, in detection order within one
+    uint32_t source_count;
+    uint32_t source_offset;       // FMCPackSource[source_count], sorted by file name
+    uint32_t string_offset;       // NUL-terminated strings; offset 0 is the empty string
+    uint32_t string_size;
+    uint32_t reserved;
+};
+
+// Fingerprint keys a profile can be indexed under (FMCPackMatchKey::kind, as bit flags in
+// FMCPackProfile::match_keys)
+enum FingerprintKeyKind : uint8_t {
+    FINGERPRINT_KEY_ICAO = 1,     // PackIcaoCode
+    FINGERPRINT_KEY_ACF_FILE = 2  // HashAcfFileName
+};
+
+// One profile; strings are offsets into the string pool
+struct FMCPackProfile {
+    uint32_t name;
+    uint32_t status_label;
+    uint32_t author;              // Detection: text the author/studio datarefs must contain
+    uint32_t studio;
+    uint32_t require_commands[PROFILE_MAX_PROBES];   // Detection probes; 0 = unused
+    uint32_t reject_commands[PROFILE_MAX_PROBES];
+    int32_t priority;
+    uint8_t has_side_specific_fmc;
+    uint8_t plus_minus;           // PlusMinusMode
+    uint8_t session_code;         // FMCSessionAircraft
+    uint8_t match_keys;           // FingerprintKeyKind flags; each one must match
+    uint32_t key_commands[2][BUTTON_COUNT];   // [side - 1][ButtonId]; 0 = no command
+    uint32_t minus_commands[2];
+    uint32_t scratchpad_datarefs[2];          // Scratchpad text dataref per side; 0 = none
+    uint8_t repeat_policy[BUTTON_COUNT];      // RepeatPolicy per ButtonId
+    uint8_t repeat_rate[BUTTON_COUNT];        // Presses per second for REPEAT_RATE_LIMIT
+    uint8_t scratchpad_write;                 // Type text by writing scratchpad_datarefs
+    uint8_t scratchpad_size;                  // Scratchpad dataref capacity in bytes; 0 = ask the dataref
+    uint8_t reserved[2];
+};
+
+// A hash bucket: match_count entries starting at match index first
+struct FMCPackBucket {
+    uint32_t first;
+    uint32_t count;
+};
+
+struct FMCPackMatchKey {
+    uint64_t key;
+    uint32_t profile;
+    uint32_t kind;                // FingerprintKeyKind
+};
+
+// A profile file the pack was compiled from
+struct FMCPackSource {
+    uint32_t name;                // File name, string pool offset
+    uint32_t reserved;
+    int64_t size;
+    int64_t modified;             // Modification time, seconds since the epoch
+};
+
+static_assert(sizeof(FMCPackHeader) == 80, "FMCPackHeader layout is part of the file format");
+static_assert(sizeof(FMCPackProfile) == 528, "FMCPackProfile layout is part of the file format");
+static_assert(sizeof(FMCPackBucket) == 8, "FMCPackBucket layout is part of the file format");
+static_assert(sizeof(FMCPackMatchKey) == 16, "FMCPackMatchKey layout is part of the file format");
+static_assert(sizeof(FMCPackSource) == 24, "FMCPackSource layout is part of the file format");
+
+// What detection knows about the loaded aircraft, read once per detection run
+static constexpr size_t FINGERPRINT_TEXT_SIZE = 128;
+
+struct AircraftFingerprint {
+    uint64_t icao;                           // PackIcaoCode of sim/aircraft/view/acf_ICAO
+    uint64_t acf_file;                       // HashAcfFileName of the .acf file name
+    char acf_path[512];                      // Full .acf path, from XPLMGetNthAircraftModel
+    char author[FINGERPRINT_TEXT_SIZE];      // sim/aircraft/view/acf_author
+    char studio[FINGERPRINT_TEXT_SIZE];      // sim/aircraft/view/acf_studio
+};
+
+// An ICAO code (up to 7 characters) as one integer: its NUL-padded bytes; 0 if it is
+// empty or longer
+uint64_t PackIcaoCode(const char* icao);
+
+// Case-insensitive hash of an .acf file name; 0 for an empty name
+uint64_t HashAcfFileName(const char* file_name);
+
+// Hash identifying one aircraft across sessions (every fingerprint field)
+uint64_t HashAircraftFingerprint(const AircraftFingerprint& fingerprint);
+
+struct ProfileSourceStamp {
+    std::string name;
+    int64_t size;
+    int64_t modified;
+};
+
+// Size and modification time of a profile file; false if it cannot be read
+bool GetProfileSourceStamp(const char* path, int64_t* size, int64_t* modified);
+
+// FNV-1a 64
+uint64_t PackChecksum(const void* data, size_t size);
+
+// Hash of profile contents, used to tie a pack to the built-in aircraft of one plugin build
+uint64_t HashAircraftProfiles(const std::vector<AircraftProfile>& profiles);
+
+// Serialize profiles (already in detection order) into a pack image
+bool BuildProfilePack(const std::vector<AircraftProfile>& profiles, const std::vector<ProfileSourceStamp>& sources,
+                      uint64_t builtin_hash, std::vector<uint8_t>* out, char* error, size_t error_size);
+
+// Read-only view of a pack image; the memory must outlive the view
+class ProfilePack {
+public:
+    ProfilePack();
+
+    // Validate the image; every offset is bounds-checked here so accessors need not be
+    bool Open(const uint8_t* data, size_t size, char* error, size_t error_size);
+    void Close();
+    bool IsOpen() const { return m_header != nullptr; }
+
+    uint64_t BuiltinHash() const { return m_header->builtin_hash; }
+    uint32_t ProfileCount() const { return m_header->profile_count; }
+    const FMCPackProfile& Profile(uint32_t index) const { return m_profiles[index]; }
+    uint32_t ProfileIndex(const FMCPackProfile* profile) const { return (uint32_t)(profile - m_profiles); }
+    const char* String(uint32_t offset) const { return m_strings + offset; }
+
+    // Hash of a profile's name, detection probes and commands; identifies the same profile
+    // across packs and sessions
+    uint64_t ProfileHash(uint32_t index) const;
+
+    // Profiles whose ICAO, .acf file, author and studio rules all accept the fingerprint, in
+    // detection order (the caller checks the command probes). Returns the number written to
+    // outProfiles, at most max_profiles; never more than MAX_CANDIDATES, so an outProfiles
+    // array of that size holds every match.
+    static constexpr uint32_t MAX_CANDIDATES = 32;   // Profiles sharing one ICAO or .acf file name
+    uint32_t FindProfiles(const AircraftFingerprint& fingerprint, uint32_t* outProfiles, uint32_t max_profiles) const;
+
+    uint32_t SourceCount() const { return m_header->source_count; }
+    bool MatchesSource(const char* name, int64_t size, int64_t modified) const;
+
+private:
+    const FMCPackHeader* m_header;
+    const FMCPackProfile* m_profiles;
+    const FMCPackBucket* m_buckets;
+    const FMCPackMatchKey* m_matches;
+    const FMCPackSource* m_sources;
+    const char* m_strings;
+};
+
+// A file mapped read-only into memory
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool Open(const char* path);
+    void Close();
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* m_data;
+    size_t m_size;
+#if defined(_WIN32)
+    void* m_file;
+    void* m_mapping;
+#endif
+};
+
+#endif // PROFILE_PACK_H
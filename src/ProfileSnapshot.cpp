@@ -0,0 +1,252 @@
+// Installed aircraft profile snapshots and the profile folder watcher (see ProfileSnapshot.h)
+
+#include "ProfileSnapshot.h"
+
+#include <algorithm>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static const size_t MAX_PROFILE_FILE_SIZE = 16 * 1024;
+
+void ProfileSnapshot::AddMessage(ProfileMessageLevel level, const char* format, ...)
+{
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    ProfileLoadMessage message;
+    message.level = level;
+    message.text = text;
+    m_messages.push_back(message);
+}
+
+// Map profiles.pack and use it in place if it was compiled from exactly these profile
+// files and this plugin's built-in aircraft
+bool ProfileSnapshot::OpenPackFile(const char* folder, const std::vector<std::string>& files, uint64_t builtin_hash)
+{
+    std::string path = std::string(folder) + "/" + FMC_PROFILE_PACK_FILE;
+    if (!m_file.Open(path.c_str())) {
+        return false;   // No pack: profile files are parsed instead
+    }
+
+    char error[128];
+    const char* stale = nullptr;
+    if (!m_pack.Open(m_file.Data(), m_file.Size(), error, sizeof(error))) {
+        AddMessage(PROFILE_MESSAGE_WARNING, "Ignoring %s: %s", FMC_PROFILE_PACK_FILE, error);
+    } else if (m_pack.BuiltinHash() != builtin_hash) {
+        stale = "compiled for another plugin version";
+    } else if (m_pack.SourceCount() != files.size()) {
+        stale = "profile files were added or removed";
+    } else {
+        for (const std::string& name : files) {
+            path = std::string(folder) + "/" + name;
+            int64_t size = 0;
+            int64_t modified = 0;
+            if (!GetProfileSourceStamp(path.c_str(), &size, &modified) || !m_pack.MatchesSource(name.c_str(), size, modified)) {
+                stale = "profile files changed";
+                break;
+            }
+        }
+    }
+    if (stale != nullptr) {
+        AddMessage(PROFILE_MESSAGE_INFO, "%s is out of date (%s), reading profile files instead", FMC_PROFILE_PACK_FILE, stale);
+    }
+    if (!m_pack.IsOpen() || stale != nullptr) {
+        m_pack.Close();
+        m_file.Close();
+        return false;
+    }
+    return true;
+}
+
+// Parse one profile file and add it to profiles; returns false if it was not used
+bool ProfileSnapshot::LoadProfileFile(const std::string& path, const std::string& file_name,
+                                      std::vector<AircraftProfile>* profiles, size_t builtin_count)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        AddMessage(PROFILE_MESSAGE_WARNING, "Cannot open aircraft profile %s", path.c_str());
+        return false;
+    }
+    std::vector<char> text(MAX_PROFILE_FILE_SIZE);
+    size_t length = fread(text.data(), 1, text.size(), file);
+    bool truncated = !feof(file);
+    fclose(file);
+    if (truncated) {
+        AddMessage(PROFILE_MESSAGE_WARNING, "Ignoring aircraft profile %s: file is larger than %d bytes",
+                   file_name.c_str(), (int)MAX_PROFILE_FILE_SIZE);
+        return false;
+    }
+
+    AircraftProfile profile;
+    char error[160];
+    if (!ParseAircraftProfile(text.data(), length, file_name.c_str(), &profile, error, sizeof(error))) {
+        AddMessage(PROFILE_MESSAGE_WARNING, "Ignoring aircraft profile %s", error);
+        return false;
+    }
+
+    switch (AddAircraftProfile(profiles, builtin_count, profile)) {
+        case PROFILE_DUPLICATE_NAME:
+            AddMessage(PROFILE_MESSAGE_WARNING, "Ignoring aircraft profile %s: another profile is already named \"%s\"",
+                       file_name.c_str(), profile.name);
+            return false;
+        case PROFILE_REPLACED_BUILTIN:
+            AddMessage(PROFILE_MESSAGE_INFO, "Aircraft profile %s replaces built-in \"%s\"", file_name.c_str(), profile.name);
+            return true;
+        default:
+            return true;
+    }
+}
+
+ProfileSnapshot* ProfileSnapshot::Load(const char* folder, const std::vector<std::string>& files)
+{
+    ProfileSnapshot* snapshot = new ProfileSnapshot();
+
+    std::vector<AircraftProfile> profiles;
+    AppendBuiltinProfiles(&profiles);
+    size_t builtin_count = profiles.size();
+    uint64_t builtin_hash = HashAircraftProfiles(profiles);
+
+    if (snapshot->OpenPackFile(folder, files, builtin_hash)) {
+        snapshot->m_loaded_files = (int)files.size();
+        snapshot->AddMessage(PROFILE_MESSAGE_INFO, "%u aircraft profiles installed from %s",
+                             snapshot->m_pack.ProfileCount(), FMC_PROFILE_PACK_FILE);
+        return snapshot;
+    }
+
+    for (const std::string& name : files) {
+        if (snapshot->LoadProfileFile(std::string(folder) + "/" + name, name, &profiles, builtin_count)) {
+            snapshot->m_loaded_files++;
+        }
+    }
+    SortAircraftProfiles(&profiles, builtin_count);
+
+    // Same layout as profiles.pack, so the rest of the plugin has one representation
+    char error[128];
+    std::vector<ProfileSourceStamp> no_sources;
+    if (!BuildProfilePack(profiles, no_sources, builtin_hash, &snapshot->m_buffer, error, sizeof(error)) ||
+        !snapshot->m_pack.Open(snapshot->m_buffer.data(), snapshot->m_buffer.size(), error, sizeof(error))) {
+        snapshot->AddMessage(PROFILE_MESSAGE_ERROR, "Failed to build the aircraft profile table: %s", error);
+        return snapshot;
+    }
+    snapshot->AddMessage(PROFILE_MESSAGE_INFO, "%u aircraft profiles installed (%d from profile files)",
+                         snapshot->m_pack.ProfileCount(), snapshot->m_loaded_files);
+    return snapshot;
+}
+
+ProfileWatcher::ProfileWatcher()
+    : m_inotify(-1), m_stop_requested(false), m_pending(nullptr)
+{
+}
+
+ProfileWatcher::~ProfileWatcher()
+{
+    Stop();
+}
+
+#if defined(__linux__)
+
+// Changes are applied once the folder has been quiet this long, so an editor's
+// write-rename-delete sequence or a batch copy produces one reload
+static const int WATCH_SETTLE_MS = 250;
+static const int WATCH_POLL_MS = 200;           // How often the thread checks for Stop
+
+static bool IsProfileFileName(const char* name)
+{
+    size_t length = strlen(name);
+    return length > 8 && strcmp(name + length - 8, ".profile") == 0;
+}
+
+bool ProfileWatcher::Start(const char* folder)
+{
+    Stop();
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0) return false;
+    if (inotify_add_watch(m_inotify, folder, IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE) < 0) {
+        close(m_inotify);
+        m_inotify = -1;
+        return false;
+    }
+    m_folder = folder;
+    m_stop_requested.store(false);
+    m_thread = std::thread(&ProfileWatcher::WatcherMain, this);
+    return true;
+}
+
+void ProfileWatcher::Stop()
+{
+    if (m_thread.joinable()) {
+        m_stop_requested.store(true);
+        m_thread.join();
+    }
+    if (m_inotify >= 0) {
+        close(m_inotify);
+        m_inotify = -1;
+    }
+    delete m_pending.exchange(nullptr);
+}
+
+void ProfileWatcher::WatcherMain()
+{
+    bool changed = false;
+    while (!m_stop_requested.load()) {
+        pollfd descriptor = {m_inotify, POLLIN, 0};
+        int ready = poll(&descriptor, 1, changed ? WATCH_SETTLE_MS : WATCH_POLL_MS);
+
+        if (ready > 0) {
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+                for (ssize_t offset = 0; offset < length;) {
+                    const inotify_event* event = (const inotify_event*)(buffer + offset);
+                    if (event->len > 0 && (IsProfileFileName(event->name) || strcmp(event->name, FMC_PROFILE_PACK_FILE) == 0)) changed = true;
+                    offset += sizeof(inotify_event) + event->len;
+                }
+            }
+            continue;   // Wait until the folder settles
+        }
+        if (!changed || ready < 0) continue;
+        changed = false;
+
+        std::vector<std::string> files;
+        DIR* directory = opendir(m_folder.c_str());
+        if (directory != nullptr) {
+            while (dirent* entry = readdir(directory)) {
+                if (IsProfileFileName(entry->d_name)) files.push_back(entry->d_name);
+            }
+            closedir(directory);
+        }
+        std::sort(files.begin(), files.end());
+
+        // Publish; a snapshot the sim thread has not taken yet is superseded
+        delete m_pending.exchange(ProfileSnapshot::Load(m_folder.c_str(), files), std::memory_order_acq_rel);
+    }
+}
+
+#else
+
+// No watcher outside Linux; profiles are loaded at startup only
+bool ProfileWatcher::Start(const char* /*folder*/)
+{
+    return false;
+}
+
+void ProfileWatcher::Stop()
+{
+    delete m_pending.exchange(nullptr);
+}
+
+void ProfileWatcher::WatcherMain()
+{
+}
+
+#endif
@@ -0,0 +1,89 @@
+// Installed aircraft profile snapshots and the profile folder watcher
+//
+// A ProfileSnapshot is one immutable, complete profile table: the built-in aircraft plus the
+// profile files of a folder, either as a mapped profiles.pack or built in memory from the
+// text files (ProfilePack.h). Loading touches no XPLM API, so snapshots can be built on any
+// thread; problems are collected as messages for the sim thread to log.
+//
+// ProfileWatcher (Linux) watches the profile folder with inotify on its own thread and
+// builds a new snapshot after every change. The sim thread takes it with TakeSnapshot and
+// swaps it in between callbacks, so key handling never waits for or sees a partial table.
+
+#ifndef PROFILE_SNAPSHOT_H
+#define PROFILE_SNAPSHOT_H
+
+#include "ProfilePack.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum ProfileMessageLevel {
+    PROFILE_MESSAGE_INFO = 0,
+    PROFILE_MESSAGE_WARNING,
+    PROFILE_MESSAGE_ERROR
+};
+
+struct ProfileLoadMessage {
+    ProfileMessageLevel level;
+    std::string text;
+};
+
+class ProfileSnapshot {
+public:
+    // Build a snapshot from the built-in aircraft and the named "*.profile" files in folder.
+    // Never fails: unusable files are skipped with a message.
+    static ProfileSnapshot* Load(const char* folder, const std::vector<std::string>& files);
+
+    const ProfilePack& Pack() const { return m_pack; }
+    bool FromPackFile() const { return m_file.Data() != nullptr; }
+    int LoadedFileCount() const { return m_loaded_files; }
+    const std::vector<ProfileLoadMessage>& Messages() const { return m_messages; }
+
+private:
+    ProfileSnapshot() : m_loaded_files(0) {}
+
+    bool OpenPackFile(const char* folder, const std::vector<std::string>& files, uint64_t builtin_hash);
+    bool LoadProfileFile(const std::string& path, const std::string& file_name,
+                         std::vector<AircraftProfile>* profiles, size_t builtin_count);
+    void AddMessage(ProfileMessageLevel level, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((format(printf, 3, 4)))
+#endif
+        ;
+
+    MappedFile m_file;                   // profiles.pack, if it was current
+    std::vector<uint8_t> m_buffer;       // Otherwise the pack image built from the text files
+    ProfilePack m_pack;
+    int m_loaded_files;
+    std::vector<ProfileLoadMessage> m_messages;
+};
+
+class ProfileWatcher {
+public:
+    ProfileWatcher();
+    ~ProfileWatcher();
+
+    // Start watching folder; false if watching is unsupported or the folder cannot be watched
+    bool Start(const char* folder);
+    void Stop();
+    bool IsRunning() const { return m_thread.joinable(); }
+
+    // The newest snapshot built since the last call, or nullptr; the caller owns it
+    ProfileSnapshot* TakeSnapshot() { return m_pending.exchange(nullptr, std::memory_order_acquire); }
+
+private:
+    ProfileWatcher(const ProfileWatcher&) = delete;
+    ProfileWatcher& operator=(const ProfileWatcher&) = delete;
+
+    void WatcherMain();
+
+    std::string m_folder;
+    int m_inotify;
+    std::atomic<bool> m_stop_requested;
+    std::atomic<ProfileSnapshot*> m_pending;
+    std::thread m_thread;
+};
+
+#endif // PROFILE_SNAPSHOT_H
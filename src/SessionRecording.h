@@ -0,0 +1,47 @@
+// Keystroke session recording file format
+//
+// While recording is on (Universal/FMC_Keyboard/Toggle_Recording) the plugin appends one
+// fixed-size record per key event it sees to FMCKeyboard_session.bin next to the plugin
+// binary. tools/harness/fmc_replay feeds a recording back through the plugin under the
+// XPLM stand-in. All fields are little-endian (every supported platform is).
+
+#ifndef SESSION_RECORDING_H
+#define SESSION_RECORDING_H
+
+#include <stdint.h>
+
+#define FMC_SESSION_MAGIC "FMCKSES"     // 7 characters + NUL fill the 8-byte magic field
+#define FMC_SESSION_VERSION 1
+
+struct FMCSessionHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;       // sizeof(FMCSessionRecord) of the writer
+};
+
+// Aircraft codes stored in FMCSessionRecord::aircraft
+enum FMCSessionAircraft {
+    FMC_SESSION_AIRCRAFT_UNKNOWN = 0,
+    FMC_SESSION_AIRCRAFT_ZIBO_737 = 1,
+    FMC_SESSION_AIRCRAFT_DEFAULT_737 = 2,
+    FMC_SESSION_AIRCRAFT_DEFAULT_A330 = 3,
+    FMC_SESSION_AIRCRAFT_DEFAULT_SR22 = 4
+};
+
+// One key event as seen by the key sniffer, and what the plugin did with it
+struct FMCSessionRecord {
+    int64_t time_ns;            // Monotonic time since recording started
+    uint8_t virtual_key;        // XPLM_VK_*
+    uint8_t flags;              // XPLMKeyFlags
+    int8_t character;           // inChar from X-Plane
+    uint8_t aircraft;           // FMCSessionAircraft detected at the time
+    uint8_t side;               // Active FMC side (1 = Captain, 2 = FO)
+    uint8_t button;             // Logical FMC button the event resolved to (0 = none)
+    uint8_t consumed;           // 1 if the plugin consumed the event
+    uint8_t reserved;
+};
+
+static_assert(sizeof(FMCSessionHeader) == 16, "FMCSessionHeader layout is part of the file format");
+static_assert(sizeof(FMCSessionRecord) == 16, "FMCSessionRecord layout is part of the file format");
+
+#endif // SESSION_RECORDING_H
@@ -0,0 +1,65 @@
+// Fixed-capacity single-producer/single-consumer ring buffer
+//
+// One thread pushes and one thread pops; no locks and no heap allocation.
+// Capacity must be a power of two so indices wrap with a mask.
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : m_head(0), m_tail(0) {}
+
+    // Producer side: returns false (and drops the item) when the ring is full
+    bool Push(const T& item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) >= Capacity) {
+            return false;
+        }
+        m_items[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: returns false when the ring is empty
+    bool Pop(T& item)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: drop everything currently queued
+    void Clear()
+    {
+        m_head.store(m_tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Approximate when called concurrently with Push/Pop; exact on either owning thread
+    size_t Size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+    static constexpr size_t GetCapacity() { return Capacity; }
+
+private:
+    T m_items[Capacity];
+    alignas(64) std::atomic<size_t> m_head;   // Next slot to pop (consumer owned)
+    alignas(64) std::atomic<size_t> m_tail;   // Next slot to push (producer owned)
+};
+
+#endif // SPSC_RING_H
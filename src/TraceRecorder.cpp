@@ -0,0 +1,110 @@
+// Opt-in Chrome trace-event recorder (see TraceRecorder.h)
+
+#include "TraceRecorder.h"
+
+#include <chrono>
+
+// How often the writer thread drains the ring; the sim thread never wakes it
+static const std::chrono::milliseconds WRITER_INTERVAL(100);
+
+TraceRecorder::TraceRecorder()
+    : m_enabled(false), m_file(nullptr), m_origin_ns(0), m_dropped(0), m_stop_requested(false)
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    Stop();
+}
+
+bool TraceRecorder::Start(const char* path)
+{
+    if (IsEnabled()) {
+        return true;
+    }
+
+    m_file = fopen(path, "wb");
+    if (m_file == nullptr) {
+        return false;
+    }
+    if (!m_ring) {
+        m_ring.reset(new EventRing());   // Allocated once, on first use
+    }
+    m_ring->Clear();
+
+    m_origin_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    m_dropped = 0;
+    m_stop_requested = false;
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Universal FMC Keyboard\"}},\n"
+          "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"X-Plane main thread\"}}",
+          m_file);
+
+    m_writer = std::thread(&TraceRecorder::WriterMain, this);
+    m_enabled.store(true, std::memory_order_release);
+    return true;
+}
+
+long long TraceRecorder::Stop()
+{
+    if (!IsEnabled()) {
+        return 0;
+    }
+    m_enabled.store(false, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop_requested = true;
+    }
+    m_wake.notify_one();
+    m_writer.join();
+
+    // The writer has exited; drain whatever the sim thread queued after its last pass
+    WriteEvents();
+    fputs("\n]}\n", m_file);
+    fclose(m_file);
+    m_file = nullptr;
+    return m_dropped;
+}
+
+void TraceRecorder::Record(const TraceEvent& event)
+{
+    if (!IsEnabled()) {
+        return;
+    }
+    if (!m_ring->Push(event)) {
+        m_dropped++;
+    }
+}
+
+void TraceRecorder::WriterMain()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop_requested) {
+        m_wake.wait_for(lock, WRITER_INTERVAL);
+        lock.unlock();
+        WriteEvents();
+        fflush(m_file);
+        lock.lock();
+    }
+}
+
+// Consumer side: format every queued event as a complete ("X") trace event
+void TraceRecorder::WriteEvents()
+{
+    TraceEvent event;
+    while (m_ring->Pop(event)) {
+        double start_us = (event.start_ns - m_origin_ns) / 1000.0;
+        double duration_us = event.duration_ns / 1000.0;
+        if (event.arg_name != nullptr) {
+            fprintf(m_file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"frame\":%d,\"%s\":%d}}",
+                    event.name, start_us, duration_us, event.frame, event.arg_name, event.arg);
+        } else {
+            fprintf(m_file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"frame\":%d}}",
+                    event.name, start_us, duration_us, event.frame);
+        }
+    }
+}
@@ -0,0 +1,65 @@
+// Opt-in Chrome trace-event recorder
+//
+// The sim thread records completed spans into a preallocated ring; a background writer
+// thread drains the ring into a Chrome trace-event JSON file that loads in Perfetto or
+// chrome://tracing. While tracing is off, Record is a single relaxed atomic load.
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include "SpscRing.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+
+// One completed span. Names must be string literals (the writer thread reads them later).
+struct TraceEvent {
+    const char* name;
+    const char* arg_name;     // nullptr = no argument besides the frame
+    int64_t start_ns;         // Monotonic clock
+    int64_t duration_ns;
+    int arg;
+    int frame;                // XPLMGetCycleNumber() when the span ended
+};
+
+class TraceRecorder {
+public:
+    static const size_t RING_CAPACITY = 16384;
+
+    TraceRecorder();
+    ~TraceRecorder();
+
+    // Allocate the ring, open the output file and start the writer thread
+    bool Start(const char* path);
+    // Stop the writer thread, flush everything still queued and close the file.
+    // Returns the number of events dropped because the ring was full.
+    long long Stop();
+    bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // Sim thread only (single producer); drops the event if the ring is full
+    void Record(const TraceEvent& event);
+
+private:
+    typedef SpscRing<TraceEvent, RING_CAPACITY> EventRing;
+
+    void WriterMain();
+    void WriteEvents();
+
+    std::atomic<bool> m_enabled;
+    std::unique_ptr<EventRing> m_ring;
+    FILE* m_file;
+    int64_t m_origin_ns;          // Timestamps are written relative to Start
+    long long m_dropped;
+
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop_requested;
+};
+
+#endif // TRACE_RECORDER_H
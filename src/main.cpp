@@ -16,6 +16,7 @@
 #endif
 
 #define XPLM200 1  // Enable X-Plane 10+ APIs (for commands)
+#define XPLM210 1  // Enable X-Plane 10.10+ APIs (livery loaded message)
 #define XPLM300 1  // Enable X-Plane 11+ APIs
 #define XPLM301 1  // Enable window decoration features
 #include "XPLMDefs.h"
@@ -30,7 +31,20 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <map>
+#include <stdint.h>
+#include <stdarg.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "SpscRing.h"
+#include "AircraftProfile.h"
+#include "ProfilePack.h"
+#include "ProfileSnapshot.h"
+#include "AvailabilityCache.h"
+#include "FMCKeyboardAPI.h"
+#include "TraceRecorder.h"
+#include "SessionRecording.h"
 
 // OpenGL headers not needed - using X-Plane SDK graphics functions only
 
@@ -40,304 +54,1098 @@
 
 // Plugin information
 #define PLUGIN_NAME "Universal FMC Keyboard Input"
-#define PLUGIN_SIG "justin.universal.fmc.keyboard"
+#define PLUGIN_SIG FMC_KEYBOARD_PLUGIN_SIGNATURE
 #define PLUGIN_DESC "Universal keyboard input handler for multiple aircraft FMC systems"
 
 // Global state variables
 static int g_toggled = 0;           // 0 = disabled, 1 = enabled
 static int g_fmc_side = 1;          // 1 = Captain, 2 = First Officer
+static bool g_key_sniffer_registered = false;  // Key sniffer is only installed while input is on
 static XPLMDataRef g_icao_dataref = NULL;
+static XPLMDataRef g_author_dataref = NULL;
+static XPLMDataRef g_studio_dataref = NULL;
 static XPLMCommandRef g_captain_command = NULL;
 static XPLMCommandRef g_fo_command = NULL;
+static XPLMCommandRef g_trace_command = NULL;
+static XPLMCommandRef g_recording_command = NULL;
 static XPLMWindowID g_status_window = NULL;
 
-// +/- button state tracking: 1 = showing +, -1 = showing -, 0 = unknown
-static int g_captain_plusminus_state = 1;   // Captain FMC +/- button state  
-static int g_fo_plusminus_state = 1;        // FO FMC +/- button state
-
-// Aircraft configuration structure
-enum AircraftType {
-    AIRCRAFT_UNKNOWN = 0,
-    AIRCRAFT_ZIBO_737,
-    AIRCRAFT_DEFAULT_737,
-    AIRCRAFT_DEFAULT_A330,
-    AIRCRAFT_DEFAULT_SR22
+// +/- handling reads the sign from the end of the scratchpad: the aircraft's scratchpad
+// dataref per side, looked up when the aircraft is detected (NULL if it has none). While
+// keystrokes for a side are queued or were just sent the dataref lags behind, so the
+// last character the queued keys will leave is predicted as well (0 = unknown).
+static XPLMDataRef g_scratchpad_datarefs[2] = {NULL, NULL};
+static char g_scratchpad_tail[2] = {0, 0};
+static int g_scratchpad_settle_cycle[2] = {0, 0};   // Dataref is current from this cycle on
+static const int SCRATCHPAD_SETTLE_FRAMES = 2;      // Frames an aircraft may take to show a key
+
+// Direct scratchpad input for profiles with scratchpad_write: characters typed while nothing
+// is queued for a side collect in its buffer, and the dispatch flight loop appends them to
+// the scratchpad dataref with one XPLMSetDatab per frame instead of one command each. Only
+// used if the dataref is writable; every other key (and any overflow) still goes through
+// the command queue, which is sent after the buffer, so key order is kept. Text that does
+// not fit the dataref, or that a write does not leave in it, is sent as key commands.
+static const int SCRATCHPAD_BUFFER_SIZE = 64;
+static const int SCRATCHPAD_TEXT_SIZE = 256;        // Longest scratchpad dataref read back
+static bool g_scratchpad_writable[2] = {false, false};
+static char g_scratchpad_buffer[2][SCRATCHPAD_BUFFER_SIZE];
+static int g_scratchpad_buffer_length[2] = {0, 0};
+
+// Installed aircraft profiles: the built-in aircraft plus any loaded from profile files,
+// in detection order (see ProfileSnapshot.h). g_profile_pack is the installed snapshot's
+// table; both are only replaced on the sim thread, by InstallProfileSnapshot.
+static ProfileSnapshot* g_profile_snapshot = nullptr;
+static const ProfilePack* g_profile_pack = nullptr;
+
+// Profile hot reload: the watcher thread builds a new snapshot after the profiles/ folder
+// changes, and this flight loop picks it up and installs it on the sim thread
+static const float PROFILE_RELOAD_INTERVAL = 0.5f;   // Seconds between checks for a new snapshot
+static ProfileWatcher g_profile_watcher;
+static XPLMFlightLoopID g_profile_reload_flight_loop = NULL;
+
+// Current aircraft detection
+// Detection runs only on plane load/unload/livery messages, plugin enable and toggle-on.
+// The result is cached here; g_aircraft_generation is bumped on every detection run so
+// per-frame and per-key code can tell whether cached derived state is still current.
+static const FMCPackProfile* g_current_profile = nullptr;
+static AircraftFingerprint g_aircraft_fingerprint;    // Read by the last detection run
+static unsigned int g_aircraft_generation = 0;
+
+// Virtual key -> logical button dispatch table, built at compile time.
+// Indexed by the unsigned virtual key; one byte per key, no heap allocation.
+struct VirtualKeyTable {
+    ButtonId buttons[256];
+};
+
+static constexpr VirtualKeyTable MakeVirtualKeyTable()
+{
+    VirtualKeyTable table = {};
+    
+    // Numbers (0-9) and letters (A-Z) are contiguous in the XPLM virtual key space
+    for (int i = 0; i < 10; i++) table.buttons[XPLM_VK_0 + i] = static_cast<ButtonId>(BUTTON_0 + i);
+    for (int i = 0; i < 26; i++) table.buttons[XPLM_VK_A + i] = static_cast<ButtonId>(BUTTON_A + i);
+    
+    // Special function keys
+    table.buttons[XPLM_VK_BACK] = BUTTON_CLR;         // Backspace -> Clear
+    table.buttons[XPLM_VK_SPACE] = BUTTON_SP;         // Space -> SP
+    table.buttons[XPLM_VK_DELETE] = BUTTON_DEL;       // Delete -> Delete
+    table.buttons[XPLM_VK_RETURN] = BUTTON_ENT;       // Enter/Return -> Enter
+    table.buttons[XPLM_VK_ENTER] = BUTTON_ENT;        // Numpad Enter -> Enter
+    table.buttons[XPLM_VK_SLASH] = BUTTON_SLASH;      // Forward slash - main keyboard (0xB8)
+    table.buttons[XPLM_VK_DIVIDE] = BUTTON_SLASH;     // Forward slash - numpad (0x6F)
+    table.buttons[XPLM_VK_PERIOD] = BUTTON_PERIOD;    // Period/decimal point (0xB9)
+    table.buttons[XPLM_VK_MINUS] = BUTTON_MINUS;      // Minus sign - main keyboard (0xB1) -> minus button
+    table.buttons[XPLM_VK_SUBTRACT] = BUTTON_MINUS;   // Minus sign - numpad (0x6D) -> minus button
+    table.buttons[XPLM_VK_ADD] = BUTTON_PLUS;         // Plus sign - numpad (0x6B) -> smart plus handling
+    // Note: XPLM_VK_EQUAL (0xB0) with Shift is handled specially in KeyCallback for Plus -> smart plus handling
+    
+    return table;
+}
+
+// Cache-line aligned so a lookup touches exactly one line
+alignas(64) static constexpr VirtualKeyTable g_virtual_key_table = MakeVirtualKeyTable();
+
+// Every virtual key the plugin claims to support (see README key mapping table)
+static constexpr int g_supported_virtual_keys[] = {
+    XPLM_VK_0, XPLM_VK_1, XPLM_VK_2, XPLM_VK_3, XPLM_VK_4,
+    XPLM_VK_5, XPLM_VK_6, XPLM_VK_7, XPLM_VK_8, XPLM_VK_9,
+    XPLM_VK_A, XPLM_VK_B, XPLM_VK_C, XPLM_VK_D, XPLM_VK_E, XPLM_VK_F, XPLM_VK_G,
+    XPLM_VK_H, XPLM_VK_I, XPLM_VK_J, XPLM_VK_K, XPLM_VK_L, XPLM_VK_M, XPLM_VK_N,
+    XPLM_VK_O, XPLM_VK_P, XPLM_VK_Q, XPLM_VK_R, XPLM_VK_S, XPLM_VK_T, XPLM_VK_U,
+    XPLM_VK_V, XPLM_VK_W, XPLM_VK_X, XPLM_VK_Y, XPLM_VK_Z,
+    XPLM_VK_BACK, XPLM_VK_SPACE, XPLM_VK_DELETE, XPLM_VK_RETURN, XPLM_VK_ENTER,
+    XPLM_VK_SLASH, XPLM_VK_DIVIDE, XPLM_VK_PERIOD, XPLM_VK_MINUS, XPLM_VK_SUBTRACT, XPLM_VK_ADD
 };
 
-struct AircraftConfig {
-    AircraftType type;
-    const char* name;
-    const char* icao;
-    const char* command_format;      // Command format with %s for key name (single FMC)
-    const char* command_format_side; // For aircraft with side-specific commands (like ZIBO)
-    const char* command_format_capt; // Captain FMC command format (for FMS/FMS2 style)
-    const char* command_format_fo;   // First Officer FMC command format (for FMS/FMS2 style)
-    const char* minus_command;       // Specific minus command for +/- toggle
-    const char* minus_command_capt;  // Captain minus command (for FMS/FMS2 style)
-    const char* minus_command_fo;    // First Officer minus command (for FMS/FMS2 style)
-    bool has_side_specific_fmc;      // Whether aircraft has separate Capt/FO FMCs
+static constexpr bool AllSupportedKeysMapped()
+{
+    for (int virtual_key : g_supported_virtual_keys) {
+        if (virtual_key < 0 || virtual_key > 255 || g_virtual_key_table.buttons[virtual_key] == BUTTON_NONE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(XPLM_VK_9 == XPLM_VK_0 + 9 && XPLM_VK_Z == XPLM_VK_A + 25, "XPLM digit/letter virtual keys must be contiguous");
+static_assert(AllSupportedKeysMapped(), "Every supported XPLM_VK_* key needs an entry in g_virtual_key_table");
+
+// ASCII character -> logical button table for text injected by other plugins (FMCKeyboardAPI.h)
+struct CharacterTable {
+    ButtonId buttons[128];
 };
 
-// Supported aircraft configurations
-static const AircraftConfig g_aircraft_configs[] = {
-    {
-        AIRCRAFT_ZIBO_737,
-        "ZIBO 737",
-        "B738",
-        nullptr,                           // Uses side-specific format
-        "laminar/B738/button/fmc%d_%s",   // Format with FMC side
-        nullptr,                           // No separate capt format
-        nullptr,                           // No separate fo format
-        "laminar/B738/button/fmc%d_minus", // Minus command format
-        nullptr,                           // No separate capt minus
-        nullptr,                           // No separate fo minus
-        true                               // Has side-specific FMCs
-    },
-    {
-        AIRCRAFT_DEFAULT_737,
-        "Default 737",
-        "B738",
-        nullptr,                           // Uses capt/fo specific formats
-        nullptr,                           // No side-specific format
-        "sim/FMS/key_%s",                  // Captain FMS commands
-        "sim/FMS2/key_%s",                 // First Officer FMS commands
-        nullptr,                           // No single minus command
-        "sim/FMS/key_minus",              // Captain minus command
-        "sim/FMS2/key_minus",             // First Officer minus command
-        true                               // Has side-specific FMCs
-    },
-    {
-        AIRCRAFT_DEFAULT_A330,
-        "Default A330",
-        "A330",
-        nullptr,                           // Uses capt/fo specific formats
-        nullptr,                           // No side-specific format
-        "sim/FMS/key_%s",                  // Captain FMS commands
-        "sim/FMS2/key_%s",                 // First Officer FMS commands
-        nullptr,                           // No single minus command
-        "sim/FMS/key_minus",              // Captain minus command
-        "sim/FMS2/key_minus",             // First Officer minus command
-        true                               // Has side-specific FMCs
-    },
-    {
-        AIRCRAFT_DEFAULT_SR22,
-        "Default SR22",
-        "SR22",
-        "sim/GPS/gcu478/%s",              // GPS GCU commands
-        nullptr,                           // No side-specific format
-        nullptr,                           // No capt format
-        nullptr,                           // No fo format
-        nullptr,                           // No plus/minus functionality
-        nullptr,                           // No capt minus
-        nullptr,                           // No fo minus
-        false                             // Single GPS system
+static constexpr CharacterTable MakeCharacterTable()
+{
+    CharacterTable table = {};
+    for (int i = 0; i < 10; i++) table.buttons['0' + i] = static_cast<ButtonId>(BUTTON_0 + i);
+    for (int i = 0; i < 26; i++) {
+        table.buttons['A' + i] = static_cast<ButtonId>(BUTTON_A + i);
+        table.buttons['a' + i] = static_cast<ButtonId>(BUTTON_A + i);   // Letters are case-insensitive
     }
+    table.buttons[' '] = BUTTON_SP;
+    table.buttons['/'] = BUTTON_SLASH;
+    table.buttons['.'] = BUTTON_PERIOD;
+    table.buttons['-'] = BUTTON_MINUS;
+    table.buttons['+'] = BUTTON_PLUS;
+    table.buttons['\n'] = BUTTON_ENT;
+    return table;
+}
+
+static constexpr CharacterTable g_character_table = MakeCharacterTable();
+
+// Pre-resolved command table for the current aircraft, indexed by [side - 1][ButtonId].
+// Filled after the aircraft is detected; NULL entries are cached misses so unsupported
+// keys are rejected without another XPLMFindCommand.
+static XPLMCommandRef g_command_table[2][BUTTON_COUNT];
+static XPLMCommandRef g_minus_command_table[2];   // +/- toggle command per side
+
+// Table entries not looked up yet: [side - 1], bit ButtonId for g_command_table, bit 0 for
+// g_minus_command_table. Resolution is a job: ResolveFlightLoop looks entries up until its
+// per-frame time budget is spent and resumes there next frame; a key that needs an entry
+// before then looks it up itself.
+static const int64_t RESOLVE_BUDGET_US = 200;
+static uint64_t g_pending_commands[2] = {0, 0};
+static_assert(BUTTON_COUNT <= 64, "g_pending_commands and the availability cache use one bit per ButtonId");
+static uint64_t g_recheck_commands[2] = {0, 0};   // Pending entries remembered as missing; looked up last
+static bool g_verify_detection = false;       // Cached detection not yet confirmed by the probes
+static int g_resolve_frames = 0;              // Frames the current resolution job has run
+static XPLMFlightLoopID g_resolve_flight_loop = NULL;
+
+// Detected profile and command availability per aircraft, kept across sessions
+static AvailabilityCache g_availability_cache;
+
+// Fully resolved tables of the last few aircraft flown, so switching back to one costs only
+// the detection probes and no lookups. Command refs stay valid for the whole X-Plane session.
+struct ResolvedTable {
+    uint64_t fingerprint;       // HashAircraftFingerprint
+    uint64_t profile_hash;      // ProfilePack::ProfileHash of the profile it was resolved for
+    uint64_t last_used;         // 0 = free slot
+    XPLMCommandRef commands[2][BUTTON_COUNT];
+    XPLMCommandRef minus_commands[2];
 };
+static const int RESOLVED_TABLE_CACHE_SIZE = 4;
+static ResolvedTable g_resolved_tables[RESOLVED_TABLE_CACHE_SIZE];
+static uint64_t g_resolved_table_sequence = 0;
 
-// Current aircraft detection
-static AircraftType g_current_aircraft = AIRCRAFT_UNKNOWN;
-static const AircraftConfig* g_current_config = nullptr;
+// Paced command dispatch: keystrokes are queued per FMC side and drained by a flight loop
+// at g_commands_per_frame commands per side per frame, so typing bursts never push several
+// characters into the FMC within one frame. The flight loop is only scheduled while a
+// queue is non-empty, so idle frames cost nothing.
+static const size_t COMMAND_QUEUE_CAPACITY = 256;
+static const int MAX_COMMANDS_PER_FRAME = 64;
+struct QueuedCommand {
+    XPLMCommandRef command;
+    ButtonId hold_button;       // BUTTON_NONE: XPLMCommandOnce; otherwise XPLMCommandBegin, held while this key is down
+};
+static SpscRing<QueuedCommand, COMMAND_QUEUE_CAPACITY> g_command_queues[2];   // [side - 1]
+
+// A queued keystroke taken back out of the queue, to be sent again with another command table
+struct RequeuedKey {
+    int side;
+    ButtonId button;            // BUTTON_NONE: a press of the +/- toggle command
+};
+static XPLMFlightLoopID g_dispatch_flight_loop = NULL;
+static bool g_dispatch_scheduled = false;
+static int g_commands_per_frame = 1;         // Writable via Universal/FMC_Keyboard/queue/commands_per_frame
+static int g_queue_overflows[2] = {0, 0};    // Commands dropped because a queue was full
+static int g_queue_high_water[2] = {0, 0};   // Deepest each queue has been
+static XPLMDataRef g_queue_datarefs[6] = {NULL, NULL, NULL, NULL, NULL, NULL};
 
-// Key mapping structure - maps virtual key codes to FMC button names
-static std::map<int, const char*> g_key_mappings;
+// Hold mode: a key's command is begun on key down and ended on key up, like pressing and
+// holding the CDU button (a held CLR clears the whole scratchpad on the ZIBO). Key state
+// and dispatch state are tracked separately, as bit ButtonId per [side - 1], because a
+// Begin may still be queued when its key is released: the dispatch flight loop ends every
+// open command whose key is no longer held, before sending anything queued after it.
+static int g_hold_keys = 0;                  // Writable via Universal/FMC_Keyboard/queue/hold_keys
+static uint64_t g_held_keys[2] = {0, 0};     // Keys down whose command was queued with a hold
+static uint64_t g_open_mask[2] = {0, 0};     // Commands sent with XPLMCommandBegin and not ended yet
+static XPLMCommandRef g_open_commands[2][BUTTON_COUNT];
+
+// Auto-repeat detection: a down event for a key that is already down is an OS repeat, and
+// the profile's RepeatPolicy for the key decides what it does. Keys down as bit ButtonId,
+// plus when each last produced a press and last had a down event, so the check is a bit
+// test and a subtraction. A key quiet for longer than any OS repeat delay lost its key up
+// (e.g. to a focus change), so its next down is a new press. Only tracked while the key
+// sniffer is installed.
+static const int64_t KEY_REPEAT_TIMEOUT_NS = 2000000000LL;   // macOS' slowest repeat delay is 1.8 s
+static uint64_t g_keys_down = 0;
+static int64_t g_key_press_ns[BUTTON_COUNT];
+static int64_t g_key_event_ns[BUTTON_COUNT];
+
+// Performance counters, published read-only under Universal/FMC_Keyboard/stats/.
+// Durations are measured with a monotonic clock and counted in log2 buckets:
+// bucket 0 is < 128 ns, bucket i is [64 << i, 128 << i) ns, the last bucket is open-ended.
+static const int STATS_HISTOGRAM_BUCKETS = 16;
+struct PluginStats {
+    int keys_seen;               // Every event delivered to KeyCallback
+    int keys_consumed;           // Events turned into FMC input
+    int keys_passed;             // Events handed back to X-Plane
+    int find_command_misses;     // XPLMFindCommand lookups that found nothing
+    int detection_runs;          // DetectAircraft calls
+    int key_repeats_dropped;     // Auto-repeat events dropped or over their rate limit
+    int key_callback_ns[STATS_HISTOGRAM_BUCKETS];
+    int draw_status_ns[STATS_HISTOGRAM_BUCKETS];
+};
+static PluginStats g_stats;
+static XPLMDataRef g_stats_datarefs[8] = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+
+// Opt-in Chrome trace of plugin activity, toggled with Universal/FMC_Keyboard/Toggle_Trace
+// and written to FMCKeyboard_trace.json next to the plugin binary
+static TraceRecorder g_trace;
+
+// Keystroke session recording (SessionRecording.h), toggled with
+// Universal/FMC_Keyboard/Toggle_Recording and written to FMCKeyboard_session.bin.
+// Records go through a large stdio buffer, so the disk is touched every few thousand keys.
+static FILE* g_session_file = NULL;
+static int64_t g_session_start_ns = 0;
+static int g_session_records = 0;
+static char g_session_buffer[64 * 1024];
+
+// Logging. LOG_INFO/LOG_WARNING/LOG_ERROR format into a fixed-size ring entry and return;
+// a flight loop drains the ring once per frame and hands the whole batch to XPLMDebugString
+// in a single call. Identical consecutive messages are coalesced into a repeat count, and
+// each call site may log at most LOG_SITE_BURST messages per LOG_SITE_WINDOW_NS; how many
+// it suppressed is reported with its next message, or once the window ends without one.
+// Producers must be on the sim thread (the ring is single-producer).
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_PRINTF_FORMAT(format_index, args_index) __attribute__((format(printf, format_index, args_index)))
+#else
+#define LOG_PRINTF_FORMAT(format_index, args_index)
+#endif
+
+enum LogLevel : uint8_t {
+    LOG_LEVEL_INFO = 0,
+    LOG_LEVEL_WARNING,
+    LOG_LEVEL_ERROR
+};
+
+// Per-call-site rate limit state (one static instance per LOG_* use)
+struct LogSite {
+    int64_t window_start_ns;
+    int messages_in_window;
+    int suppressed;
+    LogLevel level;             // Level and format of the suppressed messages, for the report
+    const char* format;
+    bool listed;                // In g_log_suppressed_sites
+};
+
+struct LogEntry {
+    LogLevel level;
+    char text[247];
+};
+
+static const int LOG_SITE_BURST = 5;
+static const int64_t LOG_SITE_WINDOW_NS = 10000000000LL;   // 10 s
+static const float LOG_REPEAT_FLUSH_INTERVAL = 1.0f;        // Seconds a repeat count may stay open
+static SpscRing<LogEntry, 64> g_log_ring;
+static XPLMFlightLoopID g_log_flight_loop = NULL;
+static bool g_log_scheduled = false;
+static int g_log_dropped = 0;                 // Entries lost because the ring was full
+static LogEntry g_log_last_entry;             // Last message written, for coalescing
+static int g_log_repeats = 0;                 // Copies of g_log_last_entry not yet reported
+static LogSite* g_log_suppressed_sites[32];   // Sites with a suppressed count FlushLog has not reported
+static int g_log_suppressed_site_count = 0;
+
+#define LOG_AT_LEVEL(level, ...) do { static LogSite log_site_ = {0, 0, 0, LOG_LEVEL_INFO, nullptr, false}; LogWrite(&log_site_, level, __VA_ARGS__); } while (0)
+#define LOG_INFO(...) LOG_AT_LEVEL(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT_LEVEL(LOG_LEVEL_WARNING, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT_LEVEL(LOG_LEVEL_ERROR, __VA_ARGS__)
 
 // Function prototypes
 static int KeyCallback(char inChar, XPLMKeyFlags inFlags, char inVirtualKey, void* inRefcon);
+static int HandleKey(int64_t time_ns, XPLMKeyFlags inFlags, unsigned char virtualKey, ButtonId* outButton);
+static bool HandleKeyRepeat(int64_t time_ns, ButtonId button);
 static void DrawStatusWindow(XPLMWindowID inWindowID, void* inRefcon);
+static void BuildStatusText(char* status_text, size_t size);
 static int CaptainCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
 static int FOCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
+static int TraceCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
+static int RecordingCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void* inRefcon);
 static void ToggleKeyboardInput(int side);
-static AircraftType DetectAircraft();
-static const AircraftConfig* GetAircraftConfig(AircraftType type);
+static void SetKeySnifferRegistered(bool registered);
+static void LoadAircraftProfiles();
+static void InstallProfileSnapshot(ProfileSnapshot* snapshot, const char* reason);
+static float ProfileReloadFlightLoop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
+static void ReadAircraftFingerprint(AircraftFingerprint* fingerprint);
+static const FMCPackProfile* DetectAircraft();
 static bool IsSupportedAircraft();
-static void InitializeKeyMappings();
-static const char* ConvertKeyName(const char* zibo_key_name);
-static void LogMessage(const char* message);
+static void RefreshAircraft(const char* reason);
+static void ClearAircraft();
+static void ResetCommandTable();
+static void ResolveCommandTable();
+static bool QueueMissingCommands();
+static void TakeQueuedKeys(std::vector<RequeuedKey>* keys);
+static void RequeueKeys(const std::vector<RequeuedKey>& keys);
+static const FMCPackProfile* FindCandidateProfile(uint64_t profile_hash);
+static const FMCPackProfile* FindResolvedTable(ResolvedTable** outTable);
+static void RestoreResolvedTable(ResolvedTable* table);
+static void StoreResolvedTable();
+static const FMCPackProfile* FindCachedAircraft(const FMCAvailabilityEntry** outEntry);
+static void LoadCachedCommandTable(const FMCAvailabilityEntry& entry);
+static XPLMCommandRef ResolvePendingCommand(int side, int bit);
+static void LogResolvedCommandTable();
+static XPLMCommandRef GetKeyCommand(int side, ButtonId button);
+static XPLMCommandRef GetMinusCommand(int side);
+static void StoreCommandAvailability();
+static void SaveCommandAvailability();
+static float ResolveFlightLoop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
+static void LogWrite(LogSite* site, LogLevel level, const char* format, ...) LOG_PRINTF_FORMAT(3, 4);
+static void ScheduleLogFlush();
+static void FlushLog(bool final);
+static float LogFlightLoop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
 static void CreateStatusWindow();
 static void UpdateStatusWindow();
-static int* GetPlusMinusStatePtr(int side);
-static void HandlePlusMinusKey(int desired_state);
-
-// Initialize key mappings
-static void InitializeKeyMappings()
-{
-    // Numbers (0-9)
-    g_key_mappings[XPLM_VK_0] = "0";
-    g_key_mappings[XPLM_VK_1] = "1";
-    g_key_mappings[XPLM_VK_2] = "2";
-    g_key_mappings[XPLM_VK_3] = "3";
-    g_key_mappings[XPLM_VK_4] = "4";
-    g_key_mappings[XPLM_VK_5] = "5";
-    g_key_mappings[XPLM_VK_6] = "6";
-    g_key_mappings[XPLM_VK_7] = "7";
-    g_key_mappings[XPLM_VK_8] = "8";
-    g_key_mappings[XPLM_VK_9] = "9";
-    
-    // Letters (A-Z)
-    g_key_mappings[XPLM_VK_A] = "A";
-    g_key_mappings[XPLM_VK_B] = "B";
-    g_key_mappings[XPLM_VK_C] = "C";
-    g_key_mappings[XPLM_VK_D] = "D";
-    g_key_mappings[XPLM_VK_E] = "E";
-    g_key_mappings[XPLM_VK_F] = "F";
-    g_key_mappings[XPLM_VK_G] = "G";
-    g_key_mappings[XPLM_VK_H] = "H";
-    g_key_mappings[XPLM_VK_I] = "I";
-    g_key_mappings[XPLM_VK_J] = "J";
-    g_key_mappings[XPLM_VK_K] = "K";
-    g_key_mappings[XPLM_VK_L] = "L";
-    g_key_mappings[XPLM_VK_M] = "M";
-    g_key_mappings[XPLM_VK_N] = "N";
-    g_key_mappings[XPLM_VK_O] = "O";
-    g_key_mappings[XPLM_VK_P] = "P";
-    g_key_mappings[XPLM_VK_Q] = "Q";
-    g_key_mappings[XPLM_VK_R] = "R";
-    g_key_mappings[XPLM_VK_S] = "S";
-    g_key_mappings[XPLM_VK_T] = "T";
-    g_key_mappings[XPLM_VK_U] = "U";
-    g_key_mappings[XPLM_VK_V] = "V";
-    g_key_mappings[XPLM_VK_W] = "W";
-    g_key_mappings[XPLM_VK_X] = "X";
-    g_key_mappings[XPLM_VK_Y] = "Y";
-    g_key_mappings[XPLM_VK_Z] = "Z";
-    
-    // Special function keys
-    g_key_mappings[XPLM_VK_BACK] = "clr";          // Backspace -> Clear
-    g_key_mappings[XPLM_VK_SPACE] = "SP";          // Space -> SP
-    g_key_mappings[XPLM_VK_DELETE] = "del";        // Delete -> Delete
-    g_key_mappings[XPLM_VK_RETURN] = "ent";        // Enter/Return -> Enter
-    g_key_mappings[XPLM_VK_ENTER] = "ent";         // Numpad Enter -> Enter
-    g_key_mappings[XPLM_VK_SLASH] = "slash";       // Forward slash - main keyboard (0xB8)
-    g_key_mappings[XPLM_VK_DIVIDE] = "slash";      // Forward slash - numpad (0x6F)
-    g_key_mappings[XPLM_VK_PERIOD] = "period";     // Period/decimal point (0xB9)
-    g_key_mappings[XPLM_VK_MINUS] = "minus";       // Minus sign - main keyboard (0xB1) -> minus button
-    g_key_mappings[XPLM_VK_SUBTRACT] = "minus";    // Minus sign - numpad (0x6D) -> minus button  
-    g_key_mappings[XPLM_VK_ADD] = "plus_key";      // Plus sign - numpad (0x6B) -> smart plus handling
-    // Note: XPLM_VK_EQUAL (0xB0) with Shift is handled specially in KeyCallback for Plus -> smart plus handling
+static void FindScratchpadDataRefs();
+static char GetScratchpadTail(int side);
+static void NoteScratchpadKey(int side, ButtonId button);
+static bool BufferScratchpadKey(int side, ButtonId button);
+static void WriteScratchpadBuffer(int side);
+static void SendScratchpadBuffer(int side);
+static int CountScratchpadWrite(int side);
+static bool EnqueueCommand(int side, XPLMCommandRef command, ButtonId hold_button = BUTTON_NONE);
+static void ClearCommandQueues();
+static void ReleaseHeldKeys();
+static void EndReleasedCommands(int side);
+static float DispatchFlightLoop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
+static void RegisterQueueDataRefs();
+static void UnregisterQueueDataRefs();
+static void RegisterStatsDataRefs();
+static void UnregisterStatsDataRefs();
+static int64_t MonotonicNanoseconds();
+static void RecordDuration(int* histogram, int64_t nanoseconds);
+static void TraceSpan(const char* name, int64_t start_ns, const char* arg_name = nullptr, int arg = 0);
+static void ToggleTrace();
+static void GetPluginFilePath(const char* file_name, char* path, size_t size);
+static void ToggleSessionRecording();
+static void RecordSessionEvent(int64_t time_ns, char inChar, XPLMKeyFlags inFlags, unsigned char virtualKey, ButtonId button, int result);
+static bool HandlePlusMinusKey(int side, ButtonId button);
+static void HandleTextMessage(FMCKeyboardTextMessage* message);
+
+static bool HasFileSuffix(const char* file_name, const char* suffix)
+{
+    size_t length = strlen(file_name);
+    size_t suffix_length = strlen(suffix);
+    return length > suffix_length && strcmp(file_name + length - suffix_length, suffix) == 0;
+}
+
+// List the "*.profile" files in a folder, sorted by name (none if the folder does not exist)
+static void ListProfileFiles(const char* folder, std::vector<std::string>* names)
+{
+    char buffer[4096];
+    char* indices[64];
+    int offset = 0;
+    int total = 0;
+    int returned = 0;
+    do {
+        if (!XPLMGetDirectoryContents(folder, offset, buffer, sizeof(buffer), indices, 64, &total, &returned) && returned == 0) {
+            break;
+        }
+        for (int i = 0; i < returned; i++) {
+            if (HasFileSuffix(indices[i], ".profile")) names->push_back(indices[i]);
+        }
+        offset += returned;
+    } while (returned > 0 && offset < total);
     
+    // Same order as ProfileWatcher, so duplicate names resolve the same way after a reload
+    std::sort(names->begin(), names->end());
+}
 
+// Install the built-in aircraft and every "*.profile" file in the plugin's profiles/ folder
+// (a current profiles.pack is used in place), then watch the folder for changes
+static void LoadAircraftProfiles()
+{
+    char folder[256];
+    GetPluginFilePath("profiles", folder, sizeof(folder));
+    std::vector<std::string> files;
+    ListProfileFiles(folder, &files);
+    InstallProfileSnapshot(ProfileSnapshot::Load(folder, files), nullptr);
+    
+    if (g_profile_watcher.Start(folder)) {
+        XPLMCreateFlightLoop_t reload_loop_params;
+        memset(&reload_loop_params, 0, sizeof(reload_loop_params));
+        reload_loop_params.structSize = sizeof(reload_loop_params);
+        reload_loop_params.phase = xplm_FlightLoop_Phase_AfterFlightModel;
+        reload_loop_params.callbackFunc = ProfileReloadFlightLoop;
+        reload_loop_params.refcon = NULL;
+        g_profile_reload_flight_loop = XPLMCreateFlightLoop(&reload_loop_params);
+        XPLMScheduleFlightLoop(g_profile_reload_flight_loop, PROFILE_RELOAD_INTERVAL, 1);
+    }
 }
 
-// Convert key name based on aircraft type (ZIBO format -> aircraft-specific format)
-static const char* ConvertKeyName(const char* zibo_key_name)
+// Make snapshot the installed profile table (sim thread only). Everything that points into
+// the old table - the detected profile and the resolved command table - is rebuilt before
+// the old snapshot is freed; key handling runs on this thread too, so it never sees a mix.
+static void InstallProfileSnapshot(ProfileSnapshot* snapshot, const char* reason)
 {
-    if (!g_current_config) return zibo_key_name;
+    // One message per profile file at most, so they are not rate limited: a folder of broken
+    // profiles must not hide all but the first few
+    for (const ProfileLoadMessage& message : snapshot->Messages()) {
+        switch (message.level) {
+            case PROFILE_MESSAGE_ERROR:
+                LogWrite(nullptr, LOG_LEVEL_ERROR, "%s", message.text.c_str());
+                break;
+            case PROFILE_MESSAGE_WARNING:
+                LogWrite(nullptr, LOG_LEVEL_WARNING, "%s", message.text.c_str());
+                break;
+            default:
+                LogWrite(nullptr, LOG_LEVEL_INFO, "%s", message.text.c_str());
+                break;
+        }
+    }
+    if (!snapshot->Pack().IsOpen() && g_profile_snapshot != nullptr) {
+        delete snapshot;   // Keep the profiles already installed
+        return;
+    }
     
-    // ZIBO aircraft uses original key names
-    if (g_current_aircraft == AIRCRAFT_ZIBO_737) {
-        return zibo_key_name;
+    ProfileSnapshot* previous = g_profile_snapshot;
+    g_profile_snapshot = snapshot;
+    g_profile_pack = snapshot->Pack().IsOpen() ? &snapshot->Pack() : nullptr;
+    if (reason != nullptr) {
+        RefreshAircraft(reason);
     }
+    delete previous;
+}
+
+// Install the snapshot the profile watcher built after the last change, if any
+static float ProfileReloadFlightLoop(float /*inElapsedSinceLastCall*/, float /*inElapsedTimeSinceLastFlightLoop*/, int /*inCounter*/, void* /*inRefcon*/)
+{
+    ProfileSnapshot* snapshot = g_profile_watcher.TakeSnapshot();
+    if (snapshot != nullptr) {
+        InstallProfileSnapshot(snapshot, "profiles reloaded");
+    }
+    return PROFILE_RELOAD_INTERVAL;
+}
+
+// Read a byte-array dataref as a NUL-terminated string (empty if the dataref is missing)
+static void ReadStringDataRef(XPLMDataRef dataref, char* text, size_t size)
+{
+    int length = (dataref != NULL) ? XPLMGetDatab(dataref, text, 0, (int)size - 1) : 0;
+    text[(length > 0) ? length : 0] = '\0';
+}
+
+// Collect everything detection matches on for the user aircraft
+static void ReadAircraftFingerprint(AircraftFingerprint* fingerprint)
+{
+    char icao[40];
+    ReadStringDataRef(g_icao_dataref, icao, sizeof(icao));
+    fingerprint->icao = PackIcaoCode(icao);
     
-    // Default aircraft (737/A330) use different key names
-    if (g_current_aircraft == AIRCRAFT_DEFAULT_737 || g_current_aircraft == AIRCRAFT_DEFAULT_A330) {
-        // Convert special keys
-        if (strcmp(zibo_key_name, "clr") == 0) return "clear";
-        if (strcmp(zibo_key_name, "SP") == 0) return "space";
-        if (strcmp(zibo_key_name, "del") == 0) return "delete";
-        if (strcmp(zibo_key_name, "ent") == 0) return "enter";
-        if (strcmp(zibo_key_name, "slash") == 0) return "slash";
-        if (strcmp(zibo_key_name, "period") == 0) return "period";
-        if (strcmp(zibo_key_name, "minus") == 0) return "minus";
-        
-        // Convert letters to lowercase (default aircraft uses lowercase)
-        static char lowercase_buffer[8];
-        if (strlen(zibo_key_name) == 1 && zibo_key_name[0] >= 'A' && zibo_key_name[0] <= 'Z') {
-            lowercase_buffer[0] = zibo_key_name[0] - 'A' + 'a';
-            lowercase_buffer[1] = '\0';
-            return lowercase_buffer;
-        }
-        
-        // Numbers and other keys remain the same
-        return zibo_key_name;
-    }
-    
-    // SR22 uses GPS GCU commands with specific naming
-    if (g_current_aircraft == AIRCRAFT_DEFAULT_SR22) {
-        // Convert special keys for SR22 GPS
-        if (strcmp(zibo_key_name, "clr") == 0) return "clr";          // Clear
-        if (strcmp(zibo_key_name, "SP") == 0) return "spc";           // Space  
-        if (strcmp(zibo_key_name, "del") == 0) return "bksp";         // Backspace
-        if (strcmp(zibo_key_name, "ent") == 0) return "ent";          // Enter
-        if (strcmp(zibo_key_name, "period") == 0) return "dot";       // Period
-        // Note: SR22 has no slash or minus functionality
-        if (strcmp(zibo_key_name, "slash") == 0) return nullptr;      // No slash support
-        if (strcmp(zibo_key_name, "minus") == 0) return nullptr;      // No minus support
+    char file_name[256] = "";
+    fingerprint->acf_path[0] = '\0';
+    XPLMGetNthAircraftModel(XPLM_USER_AIRCRAFT, file_name, fingerprint->acf_path);
+    fingerprint->acf_file = HashAcfFileName(file_name);
+    
+    ReadStringDataRef(g_author_dataref, fingerprint->author, sizeof(fingerprint->author));
+    ReadStringDataRef(g_studio_dataref, fingerprint->studio, sizeof(fingerprint->studio));
+}
+
+// Detect the current aircraft (g_aircraft_fingerprint): the first profile (in detection
+// order) whose fingerprint rules accept the loaded aircraft and whose required/rejected
+// commands are present/absent. Candidates come from the pack's hash index, so the cost
+// does not depend on how many profiles are installed.
+static const FMCPackProfile* DetectAircraft()
+{
+    if (g_icao_dataref == NULL || g_profile_pack == nullptr) return nullptr;
+    
+    uint32_t candidates[ProfilePack::MAX_CANDIDATES];
+    uint32_t count = g_profile_pack->FindProfiles(g_aircraft_fingerprint, candidates, ProfilePack::MAX_CANDIDATES);
+    for (uint32_t i = 0; i < count; i++) {
+        const FMCPackProfile& profile = g_profile_pack->Profile(candidates[i]);
         
-        // Convert letters to uppercase (SR22 GPS uses uppercase)
-        static char uppercase_buffer[8];
-        if (strlen(zibo_key_name) == 1 && zibo_key_name[0] >= 'A' && zibo_key_name[0] <= 'Z') {
-            uppercase_buffer[0] = zibo_key_name[0]; // Already uppercase
-            uppercase_buffer[1] = '\0';
-            return uppercase_buffer;
+        // Command probes tell apart aircraft sharing a fingerprint (e.g., ZIBO vs default 737)
+        bool probes_match = true;
+        for (int k = 0; k < PROFILE_MAX_PROBES && probes_match; k++) {
+            const char* require_command = g_profile_pack->String(profile.require_commands[k]);
+            const char* reject_command = g_profile_pack->String(profile.reject_commands[k]);
+            if (require_command[0] != '\0' && XPLMFindCommand(require_command) == NULL) probes_match = false;
+            if (reject_command[0] != '\0' && XPLMFindCommand(reject_command) != NULL) probes_match = false;
         }
-        
-        // Numbers remain the same
-        return zibo_key_name;
+        if (probes_match) return &profile;
     }
     
-    return zibo_key_name; // Fallback
+    return nullptr;
 }
 
-// Detect current aircraft type based on ICAO and specific characteristics
-static AircraftType DetectAircraft()
+// Check if current aircraft is supported (reads the cached detection result only)
+static bool IsSupportedAircraft()
 {
-    if (g_icao_dataref == NULL) return AIRCRAFT_UNKNOWN;
+    return (g_current_profile != nullptr);
+}
+
+// Re-run aircraft detection and rebuild the command table; called only when something changed.
+// Keystrokes still queued for the same aircraft (e.g. injected text when input is turned on)
+// are sent with the new table; those for an aircraft that was replaced are dropped.
+static void RefreshAircraft(const char* reason)
+{
+    const FMCPackProfile* previous = g_current_profile;
+    uint64_t previous_fingerprint = HashAircraftFingerprint(g_aircraft_fingerprint);
+    int64_t start = MonotonicNanoseconds();
     
-    char icao[40];
-    XPLMGetDatab(g_icao_dataref, icao, 0, sizeof(icao) - 1);
-    icao[sizeof(icao) - 1] = '\0';
-    
-    // Check for ZIBO 737 first (has specific ZIBO commands)
-    if (strcmp(icao, "B738") == 0) {
-        // Test if ZIBO-specific command exists to distinguish from default 737
-        XPLMCommandRef zibo_test = XPLMFindCommand("laminar/B738/button/fmc1_0");
-        if (zibo_test != NULL) {
-            return AIRCRAFT_ZIBO_737;
+    std::vector<RequeuedKey> keys;
+    TakeQueuedKeys(&keys);
+    g_stats.detection_runs++;
+    ReadAircraftFingerprint(&g_aircraft_fingerprint);
+    
+    // A recently flown aircraft gets its resolved table back once the detection probes agree
+    // (aircraft plugins may create their commands after the table was resolved); one seen
+    // in an earlier session starts from its cached profile and command table
+    ResolvedTable* resolved = nullptr;
+    const FMCAvailabilityEntry* cached = nullptr;
+    if ((g_current_profile = FindResolvedTable(&resolved)) != nullptr) {
+        const FMCPackProfile* detected = DetectAircraft();
+        if (detected == g_current_profile) {
+            RestoreResolvedTable(resolved);
         } else {
-            return AIRCRAFT_DEFAULT_737;
+            g_current_profile = detected;
+            ResolveCommandTable();
         }
+    } else if ((g_current_profile = FindCachedAircraft(&cached)) != nullptr) {
+        LoadCachedCommandTable(*cached);
+    } else {
+        g_current_profile = DetectAircraft();
+        ResolveCommandTable();
     }
-    
-    // Check for A330
-    if (strcmp(icao, "A330") == 0) {
-        return AIRCRAFT_DEFAULT_A330;
+    // Only side 1 is resolved for a single-FMC aircraft, even if input was turned on for
+    // the FO of the previous aircraft
+    if (g_current_profile && !g_current_profile->has_side_specific_fmc) {
+        g_fmc_side = 1;
     }
+    FindScratchpadDataRefs();
+    if (!keys.empty() && HashAircraftFingerprint(g_aircraft_fingerprint) == previous_fingerprint) {
+        RequeueKeys(keys);
+    }
+    g_aircraft_generation++;
+    TraceSpan("RefreshAircraft", start, "profile", g_current_profile ? (int)g_profile_pack->ProfileIndex(g_current_profile) : -1);
     
-    // Check for SR22
-    if (strcmp(icao, "SR22") == 0) {
-        return AIRCRAFT_DEFAULT_SR22;
+    if (g_current_profile != previous) {
+        LOG_INFO("Aircraft detected (%s): %s", reason, g_current_profile ? g_profile_pack->String(g_current_profile->name) : "unsupported");
     }
+}
+
+// Forget the detected aircraft (plane unloaded or plugin disabled)
+static void ClearAircraft()
+{
+    g_current_profile = nullptr;
+    ResetCommandTable();
+    FindScratchpadDataRefs();
+    g_aircraft_generation++;
+}
+
+// Empty the command table and cancel any resolution job
+static void ResetCommandTable()
+{
+    // Anything still queued was resolved against the previous table
+    ClearCommandQueues();
     
-    return AIRCRAFT_UNKNOWN;
+    memset(g_command_table, 0, sizeof(g_command_table));
+    memset(g_minus_command_table, 0, sizeof(g_minus_command_table));
+    g_pending_commands[0] = g_pending_commands[1] = 0;
+    g_recheck_commands[0] = g_recheck_commands[1] = 0;
+    g_verify_detection = false;
+    g_resolve_frames = 0;
 }
 
-// Get aircraft configuration for given type
-static const AircraftConfig* GetAircraftConfig(AircraftType type)
+// Start resolving every (side, key) command of the current aircraft, so the keystroke
+// path is a table index plus XPLMCommandOnce instead of snprintf + XPLMFindCommand.
+// The lookups run in ResolveFlightLoop, spread over as many frames as they need.
+static void ResolveCommandTable()
 {
-    for (size_t i = 0; i < sizeof(g_aircraft_configs) / sizeof(g_aircraft_configs[0]); i++) {
-        if (g_aircraft_configs[i].type == type) {
-            return &g_aircraft_configs[i];
+    ResetCommandTable();
+    if (!g_current_profile) return;
+    
+    // Command names were expanded when the profile was compiled
+    const FMCPackProfile& profile = *g_current_profile;
+    int side_count = g_current_profile->has_side_specific_fmc ? 2 : 1;
+    
+    for (int side = 1; side <= side_count; side++) {
+        for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+            // An empty name is a cached miss: key not supported by this aircraft (or a toggled +/- key)
+            if (g_profile_pack->String(profile.key_commands[side - 1][button])[0] != '\0') {
+                g_pending_commands[side - 1] |= 1ULL << button;
+            }
+        }
+        if (g_profile_pack->String(profile.minus_commands[side - 1])[0] != '\0') {
+            g_pending_commands[side - 1] |= 1ULL;
+        }
+    }
+    XPLMScheduleFlightLoop(g_resolve_flight_loop, -1.0f, 1);
+}
+
+// The aircraft's candidate profile with this ProfilePack::ProfileHash, i.e. the profile
+// something was remembered for, if it is still installed and unchanged
+static const FMCPackProfile* FindCandidateProfile(uint64_t profile_hash)
+{
+    uint32_t candidates[ProfilePack::MAX_CANDIDATES];
+    uint32_t count = g_profile_pack->FindProfiles(g_aircraft_fingerprint, candidates, ProfilePack::MAX_CANDIDATES);
+    for (uint32_t i = 0; i < count; i++) {
+        if (g_profile_pack->ProfileHash(candidates[i]) == profile_hash) {
+            return &g_profile_pack->Profile(candidates[i]);
         }
     }
     return nullptr;
 }
 
-// Check if current aircraft is supported
-static bool IsSupportedAircraft()
+// The profile and resolved table of g_aircraft_fingerprint, if it was flown recently
+static const FMCPackProfile* FindResolvedTable(ResolvedTable** outTable)
+{
+    if (g_profile_pack == nullptr) return nullptr;
+    uint64_t fingerprint = HashAircraftFingerprint(g_aircraft_fingerprint);
+    for (ResolvedTable& table : g_resolved_tables) {
+        if (table.last_used != 0 && table.fingerprint == fingerprint) {
+            const FMCPackProfile* profile = FindCandidateProfile(table.profile_hash);
+            if (profile != nullptr) *outTable = &table;
+            return profile;
+        }
+    }
+    return nullptr;
+}
+
+// Install a resolved table as is: nothing to look up or verify
+static void RestoreResolvedTable(ResolvedTable* table)
+{
+    ResetCommandTable();
+    memcpy(g_command_table, table->commands, sizeof(g_command_table));
+    memcpy(g_minus_command_table, table->minus_commands, sizeof(g_minus_command_table));
+    table->last_used = ++g_resolved_table_sequence;
+    if (QueueMissingCommands()) {
+        XPLMScheduleFlightLoop(g_resolve_flight_loop, -1.0f, 1);
+    }
+    
+    LOG_INFO("%s command table reused from earlier this session", g_profile_pack->String(g_current_profile->name));
+}
+
+// Remember the completed table of the current aircraft, replacing the least recently used
+static void StoreResolvedTable()
+{
+    uint64_t fingerprint = HashAircraftFingerprint(g_aircraft_fingerprint);
+    ResolvedTable* slot = &g_resolved_tables[0];
+    for (ResolvedTable& table : g_resolved_tables) {
+        if (table.last_used != 0 && table.fingerprint == fingerprint) {
+            slot = &table;
+            break;
+        }
+        if (table.last_used < slot->last_used) slot = &table;
+    }
+    slot->fingerprint = fingerprint;
+    slot->profile_hash = g_profile_pack->ProfileHash(g_profile_pack->ProfileIndex(g_current_profile));
+    slot->last_used = ++g_resolved_table_sequence;
+    memcpy(slot->commands, g_command_table, sizeof(g_command_table));
+    memcpy(slot->minus_commands, g_minus_command_table, sizeof(g_minus_command_table));
+}
+
+// The cached profile for g_aircraft_fingerprint, if the cache has one and it is still one
+// of the aircraft's candidate profiles (unchanged). Costs no XPLMFindCommand.
+static const FMCPackProfile* FindCachedAircraft(const FMCAvailabilityEntry** outEntry)
+{
+    if (g_profile_pack == nullptr) return nullptr;
+    const FMCAvailabilityEntry* entry = g_availability_cache.Find(HashAircraftFingerprint(g_aircraft_fingerprint));
+    if (entry == nullptr) return nullptr;
+    
+    const FMCPackProfile* profile = FindCandidateProfile(entry->profile_hash);
+    if (profile != nullptr) *outEntry = entry;
+    return profile;
+}
+
+// Start from the cached command availability: ResolveFlightLoop (or the first key that needs
+// them) looks up the commands known to exist, re-checks the detection probes and finally
+// looks for the commands known to be missing, in case the aircraft has them by now
+static void LoadCachedCommandTable(const FMCAvailabilityEntry& entry)
+{
+    ResetCommandTable();
+    
+    int side_count = g_current_profile->has_side_specific_fmc ? 2 : 1;
+    int pending = 0;
+    for (int side = 1; side <= 2; side++) {
+        g_pending_commands[side - 1] = (side <= side_count) ? entry.available[side - 1] : 0;
+        for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+            if (g_pending_commands[side - 1] & (1ULL << button)) pending++;
+        }
+    }
+    QueueMissingCommands();
+    g_verify_detection = true;
+    XPLMScheduleFlightLoop(g_resolve_flight_loop, -1.0f, 1);
+    
+    LOG_INFO("%s command table loaded from cache (%d commands, verifying)", g_profile_pack->String(g_current_profile->name), pending);
+}
+
+// Queue every command of the current aircraft that has a name but no table entry and is not
+// pending, as a low-priority lookup. Returns true if there is any.
+static bool QueueMissingCommands()
+{
+    const FMCPackProfile& profile = *g_current_profile;
+    int side_count = profile.has_side_specific_fmc ? 2 : 1;
+    for (int side = 1; side <= side_count; side++) {
+        uint64_t missing = 0;
+        for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+            if (g_command_table[side - 1][button] == NULL && g_profile_pack->String(profile.key_commands[side - 1][button])[0] != '\0') {
+                missing |= 1ULL << button;
+            }
+        }
+        if (g_minus_command_table[side - 1] == NULL && g_profile_pack->String(profile.minus_commands[side - 1])[0] != '\0') {
+            missing |= 1ULL;
+        }
+        missing &= ~g_pending_commands[side - 1];
+        g_pending_commands[side - 1] |= missing;
+        g_recheck_commands[side - 1] |= missing;
+    }
+    return (g_recheck_commands[0] | g_recheck_commands[1]) != 0;
+}
+
+// Look up one pending table entry (bit 0 = the side's minus command)
+static XPLMCommandRef ResolvePendingCommand(int side, int bit)
+{
+    g_pending_commands[side - 1] &= ~(1ULL << bit);
+    g_recheck_commands[side - 1] &= ~(1ULL << bit);
+    const FMCPackProfile& profile = *g_current_profile;
+    uint32_t name = (bit == 0) ? profile.minus_commands[side - 1] : profile.key_commands[side - 1][bit];
+    XPLMCommandRef command = XPLMFindCommand(g_profile_pack->String(name));
+    if (command == NULL) g_stats.find_command_misses++;
+    if (bit == 0) {
+        g_minus_command_table[side - 1] = command;
+    } else {
+        g_command_table[side - 1][bit] = command;
+    }
+    return command;
+}
+
+// Log the finished table; every name is either resolved or a miss by now
+static void LogResolvedCommandTable()
+{
+    const FMCPackProfile& profile = *g_current_profile;
+    int resolved = 0;
+    int missing = 0;
+    for (int side = 1; side <= 2; side++) {
+        for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+            if (g_command_table[side - 1][button] != NULL) {
+                resolved++;
+            } else if (g_profile_pack->String(profile.key_commands[side - 1][button])[0] != '\0') {
+                missing++;
+            }
+        }
+        if (g_minus_command_table[side - 1] == NULL && g_profile_pack->String(profile.minus_commands[side - 1])[0] != '\0') {
+            missing++;
+        }
+    }
+    LOG_INFO("%s command table resolved (%d commands, %d missing, %d frames)",
+             g_profile_pack->String(profile.name), resolved, missing, g_resolve_frames);
+}
+
+// Command for a key, looking it up first if the resolution job has not reached it yet
+static XPLMCommandRef GetKeyCommand(int side, ButtonId button)
+{
+    if (g_pending_commands[side - 1] & (1ULL << button)) {
+        return ResolvePendingCommand(side, button);
+    }
+    return g_command_table[side - 1][button];
+}
+
+static XPLMCommandRef GetMinusCommand(int side)
+{
+    if (g_pending_commands[side - 1] & 1ULL) {
+        return ResolvePendingCommand(side, 0);
+    }
+    return g_minus_command_table[side - 1];
+}
+
+// Remember the detected profile and which of its commands exist for the current aircraft
+static void StoreCommandAvailability()
+{
+    if (g_current_profile == nullptr) return;
+    
+    FMCAvailabilityEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.fingerprint = HashAircraftFingerprint(g_aircraft_fingerprint);
+    entry.profile_hash = g_profile_pack->ProfileHash(g_profile_pack->ProfileIndex(g_current_profile));
+    for (int side = 1; side <= 2; side++) {
+        if (g_minus_command_table[side - 1] != NULL) entry.available[side - 1] |= 1ULL;
+        for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+            if (g_command_table[side - 1][button] != NULL) entry.available[side - 1] |= 1ULL << button;
+        }
+    }
+    g_availability_cache.Store(entry);
+}
+
+// Write the availability cache if it changed. Only called from XPluginDisable, so switching
+// aircraft never does file I/O on the sim thread.
+static void SaveCommandAvailability()
+{
+    char path[512];
+    GetPluginFilePath(FMC_AVAILABILITY_FILE, path, sizeof(path));
+    if (!g_availability_cache.SaveIfChanged(path)) {
+        LOG_WARNING("Cannot write %s", path);
+    }
+}
+
+// Empty the command queues and scratchpad buffers into the keys they were queued for, in
+// typing order per side. Must run before the command table they were resolved with is reset.
+static void TakeQueuedKeys(std::vector<RequeuedKey>* keys)
+{
+    for (int side = 1; side <= 2; side++) {
+        for (int i = 0; i < g_scratchpad_buffer_length[side - 1]; i++) {
+            RequeuedKey key = {side, g_character_table.buttons[(unsigned char)g_scratchpad_buffer[side - 1][i]]};
+            keys->push_back(key);
+        }
+        g_scratchpad_buffer_length[side - 1] = 0;
+        
+        QueuedCommand entry;
+        while (g_command_queues[side - 1].Pop(entry)) {
+            RequeuedKey key = {side, entry.hold_button};
+            if (key.button == BUTTON_NONE && entry.command != g_minus_command_table[side - 1]) {
+                for (int button = BUTTON_NONE + 1; button < BUTTON_COUNT; button++) {
+                    if (g_command_table[side - 1][button] == entry.command) {
+                        key.button = (ButtonId)button;
+                        break;
+                    }
+                }
+            }
+            keys->push_back(key);
+        }
+    }
+}
+
+// Queue keys from TakeQueuedKeys again for the current aircraft (held keys become presses).
+// Keys it has no command for are logged as lost.
+static void RequeueKeys(const std::vector<RequeuedKey>& keys)
+{
+    int lost = 0;
+    for (const RequeuedKey& key : keys) {
+        int side = (g_current_profile && g_current_profile->has_side_specific_fmc) ? key.side : 1;
+        XPLMCommandRef command = NULL;
+        if (g_current_profile != nullptr && key.button == BUTTON_NONE) {
+            if (g_current_profile->plus_minus == PLUS_MINUS_TOGGLE) command = GetMinusCommand(side);
+        } else if (g_current_profile != nullptr) {
+            command = GetKeyCommand(side, key.button);
+        }
+        
+        bool queued = false;
+        if (command != NULL && key.button != BUTTON_NONE) {
+            queued = BufferScratchpadKey(side, key.button) || EnqueueCommand(side, command);
+            if (queued) NoteScratchpadKey(side, key.button);
+        } else if (command != NULL) {
+            queued = EnqueueCommand(side, command);
+            if (queued) g_scratchpad_tail[side - 1] = 0;
+        }
+        if (!queued) lost++;
+    }
+    if (lost > 0) {
+        LOG_WARNING("%d keystrokes typed before the aircraft was detected again could not be sent", lost);
+    }
+}
+
+// Resolution job: verify a table loaded from the cache against the detection probes, then
+// look up pending commands until RESOLVE_BUDGET_US is spent, resuming next frame. Runs only
+// while there is something to resolve.
+static float ResolveFlightLoop(float /*inElapsedSinceLastCall*/, float /*inElapsedTimeSinceLastFlightLoop*/, int /*inCounter*/, void* /*inRefcon*/)
 {
-    // Update aircraft detection
-    g_current_aircraft = DetectAircraft();
-    g_current_config = GetAircraftConfig(g_current_aircraft);
+    if (g_current_profile == nullptr) return 0.0f;
+    g_resolve_frames++;
     
-    return (g_current_config != nullptr);
+    if (g_verify_detection) {
+        g_verify_detection = false;
+        if (DetectAircraft() != g_current_profile) {
+            // The aircraft or its commands changed since it was cached: start over. Keys
+            // typed meanwhile were consumed from the sim; RefreshAircraft sends them with the
+            // new table, as the aircraft is the same.
+            g_availability_cache.Remove(HashAircraftFingerprint(g_aircraft_fingerprint));
+            RefreshAircraft("cache out of date");
+            UpdateStatusWindow();
+        }
+        return -1.0f;
+    }
+    
+    // At least one lookup per frame, so the job always finishes. Commands remembered as
+    // missing come after everything else.
+    int64_t start = MonotonicNanoseconds();
+    int64_t deadline = start + RESOLVE_BUDGET_US * 1000;
+    int resolved = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int side = 1; side <= 2; side++) {
+            uint64_t recheck = g_recheck_commands[side - 1];
+            uint64_t batch = g_pending_commands[side - 1] & ((pass == 0) ? ~recheck : recheck);
+            for (int bit = 0; bit < BUTTON_COUNT && batch != 0; bit++) {
+                if ((batch & (1ULL << bit)) == 0) continue;
+                if (resolved > 0 && MonotonicNanoseconds() >= deadline) {
+                    TraceSpan("ResolveCommands", start, "resolved", resolved);
+                    return -1.0f;
+                }
+                ResolvePendingCommand(side, bit);
+                batch &= ~(1ULL << bit);
+                resolved++;
+            }
+        }
+    }
+    TraceSpan("ResolveCommands", start, "resolved", resolved);
+    
+    // Done; the cache entry is updated in memory and written out when the plugin is disabled
+    LogResolvedCommandTable();
+    StoreResolvedTable();
+    StoreCommandAvailability();
+    return 0.0f;
 }
 
-// Log message to X-Plane log
-static void LogMessage(const char* message)
+// Wake the log flight loop for the next frame if it is idle
+static void ScheduleLogFlush()
 {
-    char full_message[512];
-    snprintf(full_message, sizeof(full_message), "Universal FMC Keyboard: %s\n", message);
-    XPLMDebugString(full_message);
+    if (g_log_flight_loop == NULL) {
+        FlushLog(true);   // Before XPluginStart created the loop or after XPluginStop destroyed it
+    } else if (!g_log_scheduled) {
+        XPLMScheduleFlightLoop(g_log_flight_loop, -1.0f, 1);
+        g_log_scheduled = true;
+    }
+}
+
+// Format a message into the log ring and wake the log flight loop. Over-limit messages from
+// a site are counted and reported with its next message, or by FlushLog once the site's
+// window has ended. A NULL site is not rate limited.
+static void LogWrite(LogSite* site, LogLevel level, const char* format, ...)
+{
+    if (site != nullptr) {
+        int64_t now = MonotonicNanoseconds();
+        if (now - site->window_start_ns >= LOG_SITE_WINDOW_NS) {
+            site->window_start_ns = now;
+            site->messages_in_window = 0;
+        }
+        if (site->messages_in_window >= LOG_SITE_BURST) {
+            site->suppressed++;
+            site->level = level;
+            site->format = format;
+            if (!site->listed && g_log_suppressed_site_count < (int)(sizeof(g_log_suppressed_sites) / sizeof(g_log_suppressed_sites[0]))) {
+                g_log_suppressed_sites[g_log_suppressed_site_count++] = site;
+                site->listed = true;
+                ScheduleLogFlush();
+            }
+            return;
+        }
+        site->messages_in_window++;
+    }
+    
+    LogEntry entry;
+    entry.level = level;
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(entry.text, sizeof(entry.text), format, args);
+    va_end(args);
+    if (site != nullptr && site->suppressed > 0 && length >= 0 && (size_t)length < sizeof(entry.text)) {
+        snprintf(entry.text + length, sizeof(entry.text) - length, " (%d similar messages suppressed)", site->suppressed);
+        site->suppressed = 0;
+    }
+    
+    if (!g_log_ring.Push(entry)) {
+        g_log_dropped++;
+    }
+    ScheduleLogFlush();
+}
+
+// Append one "Universal FMC Keyboard: ..." line to the batch, writing the batch out first if full
+static void AppendLogLine(char* batch, size_t size, size_t* used, LogLevel level, const char* text)
+{
+    static const char* const level_prefixes[] = {"", "WARNING: ", "ERROR: "};
+    char line[320];
+    int length = snprintf(line, sizeof(line), "Universal FMC Keyboard: %s%s\n", level_prefixes[level], text);
+    if (length < 0) return;
+    if ((size_t)length >= sizeof(line)) length = (int)sizeof(line) - 1;
+    
+    if (*used + length >= size) {
+        XPLMDebugString(batch);
+        *used = 0;
+    }
+    memcpy(batch + *used, line, length + 1);
+    *used += length;
+}
+
+// Write every queued message with one XPLMDebugString call, folding identical consecutive
+// messages into a repeat count. The count is reported once a different message arrives,
+// when a drain finds nothing new, or on the final flush. Suppressed counts of call sites
+// are reported once their rate limit window has ended, or on the final flush.
+static void FlushLog(bool final)
+{
+    char batch[4096];
+    size_t used = 0;
+    batch[0] = '\0';
+    bool received = false;
+    
+    LogEntry entry;
+    while (g_log_ring.Pop(entry)) {
+        received = true;
+        if (entry.level == g_log_last_entry.level && strcmp(entry.text, g_log_last_entry.text) == 0) {
+            g_log_repeats++;
+            continue;
+        }
+        if (g_log_repeats > 0) {
+            char note[64];
+            snprintf(note, sizeof(note), "Last message repeated %d more times", g_log_repeats);
+            AppendLogLine(batch, sizeof(batch), &used, g_log_last_entry.level, note);
+            g_log_repeats = 0;
+        }
+        AppendLogLine(batch, sizeof(batch), &used, entry.level, entry.text);
+        g_log_last_entry = entry;
+    }
+    
+    if (g_log_repeats > 0 && (final || !received)) {
+        char note[64];
+        snprintf(note, sizeof(note), "Last message repeated %d more times", g_log_repeats);
+        AppendLogLine(batch, sizeof(batch), &used, g_log_last_entry.level, note);
+        g_log_repeats = 0;
+        g_log_last_entry.text[0] = '\0';
+    }
+    if (g_log_dropped > 0) {
+        char note[64];
+        snprintf(note, sizeof(note), "%d log messages dropped", g_log_dropped);
+        AppendLogLine(batch, sizeof(batch), &used, LOG_LEVEL_WARNING, note);
+        g_log_dropped = 0;
+    }
+    
+    int64_t now = MonotonicNanoseconds();
+    int kept = 0;
+    for (int i = 0; i < g_log_suppressed_site_count; i++) {
+        LogSite* site = g_log_suppressed_sites[i];
+        if (site->suppressed > 0 && (final || now - site->window_start_ns >= LOG_SITE_WINDOW_NS)) {
+            char note[sizeof(LogEntry::text)];
+            snprintf(note, sizeof(note), "%d more messages like \"%.160s\" suppressed", site->suppressed, site->format);
+            AppendLogLine(batch, sizeof(batch), &used, site->level, note);
+            site->suppressed = 0;
+        }
+        if (site->suppressed > 0) {
+            g_log_suppressed_sites[kept++] = site;
+        } else {
+            site->listed = false;
+        }
+    }
+    g_log_suppressed_site_count = kept;
+    
+    if (used > 0) {
+        XPLMDebugString(batch);
+    }
+}
+
+// Flight loop: drain the log ring, then stay scheduled only while a repeat or suppressed
+// count is open
+static float LogFlightLoop(float /*inElapsedSinceLastCall*/, float /*inElapsedTimeSinceLastFlightLoop*/, int /*inCounter*/, void* /*inRefcon*/)
+{
+    FlushLog(false);
+    if (g_log_repeats > 0 || g_log_suppressed_site_count > 0) {
+        return LOG_REPEAT_FLUSH_INTERVAL;
+    }
+    g_log_scheduled = false;
+    return 0.0f;
+}
+
+// Install or remove the key sniffer. It is only registered while keyboard input is
+// toggled on, so the plugin adds no per-keystroke cost to the sim while idle.
+static void SetKeySnifferRegistered(bool registered)
+{
+    if (registered == g_key_sniffer_registered) {
+        return;
+    }
+    
+    if (registered) {
+        XPLMRegisterKeySniffer(KeyCallback, 1, NULL);
+    } else {
+        XPLMUnregisterKeySniffer(KeyCallback, 1, NULL);
+    }
+    g_key_sniffer_registered = registered;
+    g_keys_down = 0;   // Key ups are not seen while unregistered
 }
 
 // Toggle keyboard input for specified side
@@ -345,78 +1153,106 @@ static void ToggleKeyboardInput(int side)
 {
     // Validate input parameters
     if (side != 1 && side != 2) {
-        LogMessage("Invalid side parameter. Use 1 for Captain or 2 for FO");
-        return;
-    }
-    
-    // Only work with supported aircraft
-    if (!IsSupportedAircraft()) {
-        LogMessage("Current aircraft is not supported");
+        LOG_WARNING("Invalid side parameter. Use 1 for Captain or 2 for FO");
         return;
     }
     
     if (g_toggled == 0) {
+        // Re-detect when enabling: aircraft plugins may create their commands after
+        // XPLM_MSG_PLANE_LOADED has already been delivered to us
+        RefreshAircraft("toggle");
+        
+        // Only work with supported aircraft
+        if (!IsSupportedAircraft()) {
+            LOG_INFO("Current aircraft is not supported");
+            return;
+        }
+        
         g_toggled = 1;
+        SetKeySnifferRegistered(true);
         
         // For aircraft without side-specific FMCs, always use side 1 (single FMC)
-        if (!g_current_config->has_side_specific_fmc) {
+        if (!g_current_profile->has_side_specific_fmc) {
             g_fmc_side = 1;
         } else {
             g_fmc_side = side;
         }
         
-        // Reset +/- state to default (assume showing +) when enabling keyboard input
-        // since we don't know the actual state of the FMC +/- button
-        if (g_fmc_side == 1) {
-            g_captain_plusminus_state = 1; // Assume showing +
-        } else {
-            g_fo_plusminus_state = 1; // Assume showing +
-        }
-        
         const char* side_name = (side == 1) ? "Captain" : "First Officer";
-        char message[256];
         
         // Handle aircraft with or without side-specific FMCs
-        if (g_current_config->has_side_specific_fmc) {
-            snprintf(message, sizeof(message), "%s %s FMC Keyboard Input Enabled", 
-                    g_current_config->name, side_name);
+        if (g_current_profile->has_side_specific_fmc) {
+            LOG_INFO("%s %s FMC Keyboard Input Enabled", g_profile_pack->String(g_current_profile->name), side_name);
         } else {
-            snprintf(message, sizeof(message), "%s FMC Keyboard Input Enabled", 
-                    g_current_config->name);
+            LOG_INFO("%s FMC Keyboard Input Enabled", g_profile_pack->String(g_current_profile->name));
         }
-        LogMessage(message);
     } else {
         g_toggled = 0;
-        char message[256];
+        SetKeySnifferRegistered(false);
+        ReleaseHeldKeys();   // No key up will reach us any more
         
         // Handle aircraft with or without side-specific FMCs
-        if (g_current_config && g_current_config->has_side_specific_fmc) {
+        if (g_current_profile && g_current_profile->has_side_specific_fmc) {
             const char* side_name = (g_fmc_side == 1) ? "Captain" : "First Officer";
-            snprintf(message, sizeof(message), "%s %s FMC Keyboard Input Disabled", 
-                    g_current_config->name, side_name);
-        } else if (g_current_config) {
-            snprintf(message, sizeof(message), "%s FMC Keyboard Input Disabled", 
-                    g_current_config->name);
+            LOG_INFO("%s %s FMC Keyboard Input Disabled", g_profile_pack->String(g_current_profile->name), side_name);
+        } else if (g_current_profile) {
+            LOG_INFO("%s FMC Keyboard Input Disabled", g_profile_pack->String(g_current_profile->name));
         } else {
-            snprintf(message, sizeof(message), "FMC Keyboard Input Disabled");
+            LOG_INFO("FMC Keyboard Input Disabled");
         }
-        LogMessage(message);
     }
     
     // Update status window visibility
     UpdateStatusWindow();
 }
 
-// Key event callback
-static int KeyCallback(char /*inChar*/, XPLMKeyFlags inFlags, char inVirtualKey, void* /*inRefcon*/)
+// Key event callback: times and counts every event, HandleKey does the work
+static int KeyCallback(char inChar, XPLMKeyFlags inFlags, char inVirtualKey, void* /*inRefcon*/)
+{
+    int64_t start = MonotonicNanoseconds();
+    
+    // Convert to unsigned for proper key lookup
+    ButtonId button = BUTTON_NONE;
+    int result = HandleKey(start, inFlags, (unsigned char)inVirtualKey, &button);
+    
+    g_stats.keys_seen++;
+    if (result == 0) g_stats.keys_consumed++; else g_stats.keys_passed++;
+    RecordDuration(g_stats.key_callback_ns, MonotonicNanoseconds() - start);
+    TraceSpan("KeyCallback", start, "virtual_key", (unsigned char)inVirtualKey);
+    if (g_session_file != NULL) {
+        RecordSessionEvent(start, inChar, inFlags, (unsigned char)inVirtualKey, button, result);
+    }
+    return result;
+}
+
+// Turn a key event into FMC input; returns 0 if consumed, 1 to pass it on.
+// outButton receives the logical button of a consumed event.
+static int HandleKey(int64_t time_ns, XPLMKeyFlags inFlags, unsigned char virtualKey, ButtonId* outButton)
 {
-    // Only process key presses when enabled and on supported aircraft
-    if (!(inFlags & xplm_DownFlag) || g_toggled == 0 || !IsSupportedAircraft()) {
+    if (g_toggled == 0 || !IsSupportedAircraft()) {
         return 1; // Let other handlers process the key
     }
     
-    // Convert to unsigned for proper key lookup
-    unsigned char virtualKey = (unsigned char)inVirtualKey;
+    // Releasing a held key ends its command (whatever modifiers are down by now)
+    if (inFlags & xplm_UpFlag) {
+        ButtonId button = (virtualKey == XPLM_VK_EQUAL) ? BUTTON_PLUS : g_virtual_key_table.buttons[virtualKey];
+        if (button == BUTTON_NONE) {
+            return 1;
+        }
+        g_keys_down &= ~(1ULL << button);
+        if (!(g_held_keys[g_fmc_side - 1] & (1ULL << button))) {
+            return 1;
+        }
+        g_held_keys[g_fmc_side - 1] &= ~(1ULL << button);
+        EnqueueCommand(g_fmc_side, NULL);   // Wake the dispatch flight loop to end it
+        *outButton = button;
+        return 0;
+    }
+    
+    // Only process key presses
+    if (!(inFlags & xplm_DownFlag)) {
+        return 1; // Let other handlers process the key
+    }
     
     // Check if any modifier keys are pressed - but allow Shift+Equal for plus sign
     // This fixes the issue where combo keys (like CTRL+SHIFT+I) still input letters to FMC
@@ -425,72 +1261,89 @@ static int KeyCallback(char /*inChar*/, XPLMKeyFlags inFlags, char inVirtualKey,
         return 1; // Let other handlers (like key commands) process modifier key combinations
     }
     
-    // Determine the desired state and button name
-    const char* button_name = nullptr;
-    int desired_plusminus_state = 0; // 1 = want +, -1 = want -, 0 = not a +/- key
+    // Determine the logical button
+    ButtonId button = hasShiftEqual ? BUTTON_PLUS : g_virtual_key_table.buttons[virtualKey];
+    if (button == BUTTON_NONE) {
+        return 1; // Not an FMC key
+    }
     
-    if (hasShiftEqual) {
-        // Shift+Equal = Plus
-        button_name = "plus_key";
-        desired_plusminus_state = 1; // Want plus sign
-    } else {
-        auto it = g_key_mappings.find(virtualKey);
-        if (it != g_key_mappings.end()) {
-            button_name = it->second;
-            if (strcmp(button_name, "minus") == 0) {
-                // Minus key -> want minus sign
-                desired_plusminus_state = -1;
-            } else if (strcmp(button_name, "plus_key") == 0) {
-                // Plus key -> want plus sign  
-                desired_plusminus_state = 1;
-            }
+    // A key that is already down is being auto-repeated by the OS, unless its key up was lost
+    uint64_t bit = 1ULL << button;
+    if ((g_keys_down & bit) && time_ns - g_key_event_ns[button] >= KEY_REPEAT_TIMEOUT_NS) {
+        g_keys_down &= ~bit;
+        if (g_held_keys[g_fmc_side - 1] & bit) {
+            g_held_keys[g_fmc_side - 1] &= ~bit;
+            EnqueueCommand(g_fmc_side, NULL);   // Wake the dispatch flight loop to end it
+        }
+    }
+    g_key_event_ns[button] = time_ns;
+    if (g_keys_down & bit) {
+        if (!HandleKeyRepeat(time_ns, button)) {
+            *outButton = button;
+            return 0; // Consumed without a key press
         }
     }
+    g_keys_down |= bit;
+    g_key_press_ns[button] = time_ns;
     
-    if (button_name != nullptr) {
-        // Handle +/- keys with intelligent state management
-        if (desired_plusminus_state != 0) {
-            HandlePlusMinusKey(desired_plusminus_state);
-            return 0; // Consume the key event
-        } else {
-            // Handle normal keys (non +/- keys) 
-            char command_string[256];
-            
-            // Convert key name to aircraft-specific format
-            const char* converted_key_name = ConvertKeyName(button_name);
-            
-            // Check if the key is supported by current aircraft
-            if (converted_key_name == nullptr) {
-                // Key not supported by this aircraft (e.g., slash/minus on SR22)
-                return 1; // Let other handlers process the key
-            }
-            
-            // Generate command based on aircraft configuration
-            if (g_current_config->command_format_capt && g_current_config->command_format_fo) {
-                // Aircraft with separate Capt/FO formats (like default 737/A330)
-                const char* format = (g_fmc_side == 1) ? g_current_config->command_format_capt : g_current_config->command_format_fo;
-                snprintf(command_string, sizeof(command_string), format, converted_key_name);
-            } else if (g_current_config->has_side_specific_fmc && g_current_config->command_format_side) {
-                // Aircraft with side-specific FMCs (like ZIBO)
-                snprintf(command_string, sizeof(command_string), g_current_config->command_format_side, g_fmc_side, converted_key_name);
-            } else if (g_current_config->command_format) {
-                // Aircraft with single FMC system (like SR22)
-                snprintf(command_string, sizeof(command_string), g_current_config->command_format, converted_key_name);
-            } else {
-                return 1; // No valid command format
-            }
-            
-            XPLMCommandRef command = XPLMFindCommand(command_string);
-            if (command != NULL) {
-                XPLMCommandOnce(command);
-                return 0; // Consume the key event
-            }
+    // Handle +/- keys with intelligent state management
+    if (button == BUTTON_MINUS || button == BUTTON_PLUS) {
+        HandlePlusMinusKey(g_fmc_side, button);
+        *outButton = button;
+        return 0; // Consume the key event
+    }
+    
+    // Handle normal keys (non +/- keys) through the pre-resolved command table.
+    // A NULL entry means the key is not supported by this aircraft (e.g., slash on SR22)
+    XPLMCommandRef command = GetKeyCommand(g_fmc_side, button);
+    if (command != NULL) {
+        if (g_hold_keys == 0) {
+            if (!BufferScratchpadKey(g_fmc_side, button)) EnqueueCommand(g_fmc_side, command);
+        } else if (!(g_held_keys[g_fmc_side - 1] & (1ULL << button)) && EnqueueCommand(g_fmc_side, command, button)) {
+            g_held_keys[g_fmc_side - 1] |= 1ULL << button;
         }
+        NoteScratchpadKey(g_fmc_side, button);
+        *outButton = button;
+        return 0; // Consume the key event
     }
     
     return 1; // Let other handlers process the key
 }
 
+// Apply the profile's RepeatPolicy to an auto-repeat of a key; returns true if it is
+// another key press
+static bool HandleKeyRepeat(int64_t time_ns, ButtonId button)
+{
+    uint64_t bit = 1ULL << button;
+    if (g_held_keys[g_fmc_side - 1] & bit) {
+        return false;   // Already held down (hold mode or an earlier repeat)
+    }
+    
+    switch ((RepeatPolicy)g_current_profile->repeat_policy[button]) {
+        case REPEAT_PASS:
+            return true;
+        case REPEAT_RATE_LIMIT:
+            if (time_ns - g_key_press_ns[button] >= 1000000000LL / g_current_profile->repeat_rate[button]) {
+                return true;
+            }
+            break;
+        case REPEAT_HOLD: {
+            // The first press already went out as a tap; now hold the button until key up
+            XPLMCommandRef command = (button == BUTTON_MINUS || button == BUTTON_PLUS) ? NULL : GetKeyCommand(g_fmc_side, button);
+            if (command != NULL && EnqueueCommand(g_fmc_side, command, button)) {
+                g_held_keys[g_fmc_side - 1] |= bit;
+                NoteScratchpadKey(g_fmc_side, button);
+                return false;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    g_stats.key_repeats_dropped++;
+    return false;
+}
+
 // Create status window using modern X-Plane window system
 static void CreateStatusWindow()
 {
@@ -529,9 +1382,9 @@ static void CreateStatusWindow()
     g_status_window = XPLMCreateWindowEx(&window_params);
     
     if (g_status_window != NULL) {
-        LogMessage("Status window created successfully");
+        LOG_INFO("Status window created successfully");
     } else {
-        LogMessage("Failed to create status window");
+        LOG_ERROR("Failed to create status window");
     }
 }
 
@@ -550,6 +1403,8 @@ static void UpdateStatusWindow()
 // Draw status window content
 static void DrawStatusWindow(XPLMWindowID inWindowID, void* /*inRefcon*/)
 {
+    int64_t start = MonotonicNanoseconds();
+    
     // Get window geometry
     int left, top, right, bottom;
     XPLMGetWindowGeometry(inWindowID, &left, &top, &right, &bottom);
@@ -560,73 +1415,667 @@ static void DrawStatusWindow(XPLMWindowID inWindowID, void* /*inRefcon*/)
     // Draw semi-transparent background
     XPLMDrawTranslucentDarkBox(left, top, right, bottom);
     
-    // Prepare status text
-    char status_text[32];
-    if (g_current_config && g_current_config->has_side_specific_fmc) {
-        const char* side_text = (g_fmc_side == 1) ? "CAP" : "FO";
-        snprintf(status_text, sizeof(status_text), "KB:%s", side_text);
-    } else if (g_current_config) {
-        // For aircraft without side-specific FMCs, show aircraft type
-        const char* aircraft_short = "";
-        if (g_current_aircraft == AIRCRAFT_DEFAULT_737) aircraft_short = "737";
-        else if (g_current_aircraft == AIRCRAFT_DEFAULT_A330) aircraft_short = "330";
-        else if (g_current_aircraft == AIRCRAFT_DEFAULT_SR22) aircraft_short = "SR22";
-        else aircraft_short = "FMC";
-        snprintf(status_text, sizeof(status_text), "KB:%s", aircraft_short);
-    } else {
-        snprintf(status_text, sizeof(status_text), "KB:ON");
+    // Status text only changes with the detected aircraft or the FMC side, so it is
+    // rebuilt only when either differs from the values it was last built for
+    static char status_text[32];
+    static unsigned int status_generation = 0;
+    static int status_side = 0;
+    if (status_generation != g_aircraft_generation || status_side != g_fmc_side || status_text[0] == '\0') {
+        status_generation = g_aircraft_generation;
+        status_side = g_fmc_side;
+        BuildStatusText(status_text, sizeof(status_text));
     }
     
     // Draw bright green status text
     float green_color[3] = {0.0f, 1.0f, 0.0f};
     XPLMDrawString(green_color, left + 5, top - 15, status_text, NULL, xplmFont_Basic);
+    
+    RecordDuration(g_stats.draw_status_ns, MonotonicNanoseconds() - start);
+    TraceSpan("DrawStatusWindow", start);
+}
+
+// Build the status window label for the current aircraft and FMC side
+static void BuildStatusText(char* status_text, size_t size)
+{
+    if (g_current_profile && g_current_profile->has_side_specific_fmc) {
+        const char* side_text = (g_fmc_side == 1) ? "CAP" : "FO";
+        snprintf(status_text, size, "KB:%s", side_text);
+    } else if (g_current_profile) {
+        // For aircraft without side-specific FMCs, show the profile's label
+        const char* label = g_profile_pack->String(g_current_profile->status_label);
+        snprintf(status_text, size, "KB:%s", (label[0] != '\0') ? label : "FMC");
+    } else {
+        snprintf(status_text, size, "KB:ON");
+    }
 }
 
-// Get pointer to the correct +/- state variable based on FMC side
-static int* GetPlusMinusStatePtr(int side)
+// Look up the current aircraft's scratchpad datarefs (once per detection, not per key)
+static void FindScratchpadDataRefs()
 {
-    return (side == 1) ? &g_captain_plusminus_state : &g_fo_plusminus_state;
+    for (int side = 1; side <= 2; side++) {
+        g_scratchpad_datarefs[side - 1] = NULL;
+        g_scratchpad_tail[side - 1] = 0;
+        g_scratchpad_writable[side - 1] = false;
+        g_scratchpad_buffer_length[side - 1] = 0;
+        if (g_current_profile == nullptr) continue;
+        const char* name = g_profile_pack->String(g_current_profile->scratchpad_datarefs[side - 1]);
+        if (name[0] == '\0') continue;
+        XPLMDataRef dataref = XPLMFindDataRef(name);
+        if (dataref != NULL && (XPLMGetDataRefTypes(dataref) & xplmType_Data)) {
+            g_scratchpad_datarefs[side - 1] = dataref;
+        }
+        if (g_current_profile->scratchpad_write) {
+            g_scratchpad_writable[side - 1] = g_scratchpad_datarefs[side - 1] != NULL && XPLMCanWriteDataRef(dataref);
+            if (!g_scratchpad_writable[side - 1]) {
+                LOG_WARNING("Scratchpad dataref %s is missing or read-only, typing with commands", name);
+            }
+        }
+    }
 }
 
-// Handle +/- key press with intelligent state management using aircraft-specific minus command
-static void HandlePlusMinusKey(int desired_state)
+// Last character on a side's scratchpad once everything queued for it has been sent
+// (0 if empty or unknown). Read from the aircraft when nothing is in flight.
+static char GetScratchpadTail(int side)
 {
-    if (!g_current_config) return;
+    XPLMDataRef dataref = g_scratchpad_datarefs[side - 1];
+    if (dataref == NULL || !g_command_queues[side - 1].Empty() || g_scratchpad_buffer_length[side - 1] != 0 ||
+        XPLMGetCycleNumber() < g_scratchpad_settle_cycle[side - 1]) {
+        return g_scratchpad_tail[side - 1];
+    }
     
-    // Check if current aircraft supports +/- functionality
-    if (!g_current_config->minus_command && !g_current_config->minus_command_capt && !g_current_config->minus_command_fo) {
-        // Aircraft like SR22 don't have +/- functionality, ignore the key press
+    char text[SCRATCHPAD_TEXT_SIZE];
+    int length = XPLMGetDatab(dataref, text, 0, sizeof(text));
+    char tail = 0;
+    for (int i = 0; i < length && text[i] != '\0'; i++) {
+        if (text[i] != ' ') tail = text[i];
+    }
+    g_scratchpad_tail[side - 1] = tail;
+    return tail;
+}
+
+// Character a key puts on the scratchpad (0 for CLR, DEL, ENT and +/-)
+static char ScratchpadCharacter(ButtonId button)
+{
+    if (button >= BUTTON_0 && button <= BUTTON_9) return (char)('0' + (button - BUTTON_0));
+    if (button >= BUTTON_A && button <= BUTTON_Z) return (char)('A' + (button - BUTTON_A));
+    if (button == BUTTON_SLASH) return '/';
+    if (button == BUTTON_PERIOD) return '.';
+    if (button == BUTTON_SP) return ' ';
+    return 0;
+}
+
+// Predict the scratchpad after a queued key: characters append, anything else (CLR, DEL,
+// ENT) leaves the end unknown
+static void NoteScratchpadKey(int side, ButtonId button)
+{
+    char tail = ScratchpadCharacter(button);
+    g_scratchpad_tail[side - 1] = (tail == ' ') ? 0 : tail;
+}
+
+// Type a key by buffering its character for a direct scratchpad write. Returns false if the
+// side has no writable scratchpad, the key is not a character, commands are still queued
+// ahead of it or the buffer is full; the key is then sent as a command.
+static bool BufferScratchpadKey(int side, ButtonId button)
+{
+    char character = ScratchpadCharacter(button);
+    int length = g_scratchpad_buffer_length[side - 1];
+    if (!g_scratchpad_writable[side - 1] || character == 0 || !g_command_queues[side - 1].Empty() ||
+        length >= SCRATCHPAD_BUFFER_SIZE) {
+        return false;
+    }
+    g_scratchpad_buffer[side - 1][length] = character;
+    g_scratchpad_buffer_length[side - 1] = length + 1;
+    EnqueueCommand(side, NULL);   // Wake the dispatch flight loop to write it
+    return true;
+}
+
+// Bytes a side's scratchpad dataref can hold: the profile's scratchpad_size, else what the
+// dataref reports for a NULL buffer (its full size, not just the text it returns)
+static int GetScratchpadCapacity(int side)
+{
+    int capacity = g_current_profile->scratchpad_size;
+    if (capacity == 0) capacity = XPLMGetDatab(g_scratchpad_datarefs[side - 1], NULL, 0, 0);
+    return (capacity < SCRATCHPAD_TEXT_SIZE) ? capacity : SCRATCHPAD_TEXT_SIZE;
+}
+
+// Number of a side's buffered characters the next scratchpad write takes. Spaces typed
+// last stay buffered until a character follows them (or a command is queued behind them),
+// as written alone they would read back as padding.
+static int CountScratchpadWrite(int side)
+{
+    int count = g_scratchpad_buffer_length[side - 1];
+    if (g_command_queues[side - 1].Empty()) {
+        while (count > 0 && g_scratchpad_buffer[side - 1][count - 1] == ' ') count--;
+    }
+    return count;
+}
+
+// Append a side's buffered characters to the end of its scratchpad text with one dataref
+// write. The text ends at the first NUL, less any trailing spaces, which are padding.
+// Text that does not fit is typed with key commands instead, and so is text the dataref
+// does not take, after which the side types with commands only.
+static void WriteScratchpadBuffer(int side)
+{
+    const char* characters = g_scratchpad_buffer[side - 1];
+    int length = g_scratchpad_buffer_length[side - 1];
+    if (!g_scratchpad_writable[side - 1]) {
+        SendScratchpadBuffer(side);
         return;
     }
+    int count = CountScratchpadWrite(side);
+    if (count == 0) return;
     
-    int* current_state = GetPlusMinusStatePtr(g_fmc_side);
+    XPLMDataRef dataref = g_scratchpad_datarefs[side - 1];
+    int capacity = GetScratchpadCapacity(side);
+    char text[SCRATCHPAD_TEXT_SIZE];
+    int size = XPLMGetDatab(dataref, text, 0, capacity);
+    int end = 0;
+    while (end < size && text[end] != '\0') end++;
+    bool terminated = end < size;
+    while (end > 0 && text[end - 1] == ' ') end--;
+    if (end + count > capacity) {
+        SendScratchpadBuffer(side);
+        return;
+    }
     
-    // If we already have the desired state, do nothing
-    if (*current_state == desired_state) {
+    memcpy(text + end, characters, count);
+    int written = count;
+    if (terminated && end + written < capacity) {
+        text[end + written++] = '\0';
+    }
+    XPLMSetDatab(dataref, text + end, end, written);
+    char check[SCRATCHPAD_TEXT_SIZE];
+    if (XPLMGetDatab(dataref, check, end, count) != count || memcmp(check, text + end, count) != 0) {
+        LOG_WARNING("Scratchpad dataref %s does not take writes, typing with commands",
+                    g_profile_pack->String(g_current_profile->scratchpad_datarefs[side - 1]));
+        g_scratchpad_writable[side - 1] = false;
+        SendScratchpadBuffer(side);
         return;
     }
+    memmove(g_scratchpad_buffer[side - 1], characters + count, length - count);
+    g_scratchpad_buffer_length[side - 1] = length - count;
+}
+
+// Type a side's buffered characters with key commands, ahead of the commands queued after them
+static void SendScratchpadBuffer(int side)
+{
+    SpscRing<QueuedCommand, COMMAND_QUEUE_CAPACITY>& queue = g_command_queues[side - 1];
+    QueuedCommand later[COMMAND_QUEUE_CAPACITY];
+    int later_count = 0;
+    while (later_count < (int)COMMAND_QUEUE_CAPACITY && queue.Pop(later[later_count])) later_count++;
+    
+    const char* characters = g_scratchpad_buffer[side - 1];
+    int length = g_scratchpad_buffer_length[side - 1];
+    g_scratchpad_buffer_length[side - 1] = 0;
+    for (int i = 0; i < length; i++) {
+        ButtonId button = g_character_table.buttons[(unsigned char)characters[i]];
+        EnqueueCommand(side, GetKeyCommand(side, button));
+    }
+    for (int i = 0; i < later_count; i++) {
+        EnqueueCommand(side, later[i].command, later[i].hold_button);
+    }
+}
+
+// Handle +/- key press using the aircraft-specific minus command, which on a Boeing-style
+// CDU appends "-" to the scratchpad, or flips a trailing "-" or "+". The number of presses
+// comes from the real end of the scratchpad, so none is wasted. Returns false if the
+// aircraft has no +/- key or the command could not be queued.
+static bool HandlePlusMinusKey(int side, ButtonId button)
+{
+    if (!g_current_profile) return false;
+    
+    if (g_current_profile->plus_minus == PLUS_MINUS_NONE) {
+        // Aircraft like SR22 don't have +/- functionality, ignore the key press
+        return false;
+    }
+    if (g_current_profile->plus_minus == PLUS_MINUS_KEYS) {
+        // Separate MINUS/PLUS keys: no sign state to track
+        XPLMCommandRef key_command = GetKeyCommand(side, button);
+        return key_command != NULL && EnqueueCommand(side, key_command);
+    }
     
-    // Generate minus command based on aircraft configuration
-    char command_string[256];
-    if (g_current_config->minus_command_capt && g_current_config->minus_command_fo) {
-        // Aircraft with separate Capt/FO minus commands (like default 737/A330)
-        const char* minus_cmd = (g_fmc_side == 1) ? g_current_config->minus_command_capt : g_current_config->minus_command_fo;
-        strcpy(command_string, minus_cmd);
-    } else if (g_current_config->has_side_specific_fmc && g_current_config->minus_command && strstr(g_current_config->minus_command, "%d")) {
-        // Aircraft with side-specific minus commands (like ZIBO)
-        snprintf(command_string, sizeof(command_string), g_current_config->minus_command, g_fmc_side);
-    } else if (g_current_config->minus_command) {
-        // Aircraft with single minus command
-        strcpy(command_string, g_current_config->minus_command);
+    char desired = (button == BUTTON_PLUS) ? '+' : '-';
+    char tail = GetScratchpadTail(side);
+    int presses;
+    if (tail == desired) {
+        presses = 0;   // Already there
+    } else if (tail == '-' || tail == '+' || desired == '-') {
+        presses = 1;   // Flip the sign, or append "-"
     } else {
-        return; // No minus command available
+        presses = 2;   // Append "-", then flip it to "+"
     }
     
-    XPLMCommandRef command = XPLMFindCommand(command_string);
+    // Use the pre-resolved minus command for this side
+    XPLMCommandRef command = GetMinusCommand(side);
+    if (command == NULL) {
+        return false;
+    }
+    for (int i = 0; i < presses; i++) {
+        if (!EnqueueCommand(side, command)) return false;
+    }
+    g_scratchpad_tail[side - 1] = desired;
+    return true;
+}
+
+// Queue a command for paced dispatch on the given FMC side; with a hold_button it is begun
+// and stays open until that key is released. A NULL command queues nothing and only wakes
+// the dispatch flight loop. Returns false (and counts an overflow) if the side's queue is full.
+static bool EnqueueCommand(int side, XPLMCommandRef command, ButtonId hold_button)
+{
     if (command != NULL) {
-        XPLMCommandOnce(command);
-        *current_state = desired_state;  // Update our state tracking
+        SpscRing<QueuedCommand, COMMAND_QUEUE_CAPACITY>& queue = g_command_queues[side - 1];
+        QueuedCommand entry = {command, hold_button};
+        if (!queue.Push(entry)) {
+            g_queue_overflows[side - 1]++;
+            LOG_WARNING("Command queue full, dropping keystrokes");
+            return false;
+        }
+        
+        int depth = (int)queue.Size();
+        if (depth > g_queue_high_water[side - 1]) {
+            g_queue_high_water[side - 1] = depth;
+        }
+    }
+    
+    // Wake the dispatch flight loop for the next frame if it is idle
+    if (!g_dispatch_scheduled && g_dispatch_flight_loop != NULL) {
+        XPLMScheduleFlightLoop(g_dispatch_flight_loop, -1.0f, 1);
+        g_dispatch_scheduled = true;
+    }
+    return true;
+}
+
+// Drop all queued commands and end every open one (aircraft changed or plugin shutting down)
+static void ClearCommandQueues()
+{
+    g_command_queues[0].Clear();
+    g_command_queues[1].Clear();
+    g_scratchpad_buffer_length[0] = g_scratchpad_buffer_length[1] = 0;
+    g_held_keys[0] = g_held_keys[1] = 0;
+    EndReleasedCommands(1);
+    EndReleasedCommands(2);
+}
+
+// Treat every held key as released (input toggled off or hold mode turned off); their
+// commands are ended once whatever was queued before them has been sent
+static void ReleaseHeldKeys()
+{
+    if (g_held_keys[0] == 0 && g_held_keys[1] == 0) return;
+    g_held_keys[0] = g_held_keys[1] = 0;
+    EnqueueCommand(1, NULL);
+}
+
+// End the open commands of a side whose keys are no longer held
+static void EndReleasedCommands(int side)
+{
+    uint64_t released = g_open_mask[side - 1] & ~g_held_keys[side - 1];
+    for (int button = BUTTON_NONE + 1; released != 0 && button < BUTTON_COUNT; button++) {
+        if (released & (1ULL << button)) {
+            XPLMCommandEnd(g_open_commands[side - 1][button]);
+            g_open_commands[side - 1][button] = NULL;
+            released &= ~(1ULL << button);
+        }
+    }
+    g_open_mask[side - 1] &= g_held_keys[side - 1];
+}
+
+// Flight loop: write each side's buffered scratchpad text, send up to g_commands_per_frame
+// queued commands per side, then unschedule itself once both queues are empty
+static float DispatchFlightLoop(float /*inElapsedSinceLastCall*/, float /*inElapsedTimeSinceLastFlightLoop*/, int /*inCounter*/, void* /*inRefcon*/)
+{
+    bool pending = false;
+    bool tracing = g_trace.IsEnabled();
+    int64_t start = tracing ? MonotonicNanoseconds() : 0;
+    int total_sent = 0;
+    
+    for (int side = 0; side < 2; side++) {
+        QueuedCommand entry;
+        int sent = 0;
+        // Buffered characters were typed before anything still in the queue
+        bool wrote = g_scratchpad_buffer_length[side] != 0;
+        if (wrote) {
+            int64_t write_start = tracing ? MonotonicNanoseconds() : 0;
+            WriteScratchpadBuffer(side + 1);
+            if (tracing) TraceSpan("XPLMSetDatab", write_start, "side", side + 1);
+        }
+        EndReleasedCommands(side + 1);
+        for (; sent < g_commands_per_frame && g_command_queues[side].Pop(entry); sent++) {
+            int64_t command_start = tracing ? MonotonicNanoseconds() : 0;
+            if (entry.hold_button == BUTTON_NONE) {
+                XPLMCommandOnce(entry.command);
+                if (tracing) TraceSpan("XPLMCommandOnce", command_start, "side", side + 1);
+            } else {
+                // Pressed again before the previous hold was ended: release that one first
+                uint64_t bit = 1ULL << entry.hold_button;
+                if (g_open_mask[side] & bit) XPLMCommandEnd(g_open_commands[side][entry.hold_button]);
+                XPLMCommandBegin(entry.command);
+                g_open_commands[side][entry.hold_button] = entry.command;
+                g_open_mask[side] |= bit;
+                if (tracing) TraceSpan("XPLMCommandBegin", command_start, "side", side + 1);
+            }
+            // A key released before its Begin was sent becomes a tap
+            EndReleasedCommands(side + 1);
+        }
+        total_sent += sent;
+        if (sent > 0 || wrote) {
+            g_scratchpad_settle_cycle[side] = XPLMGetCycleNumber() + SCRATCHPAD_SETTLE_FRAMES;
+        }
+        if (!g_command_queues[side].Empty()) {
+            pending = true;
+        }
+    }
+    if (tracing) TraceSpan("DispatchFlightLoop", start, "commands", total_sent);
+    
+    if (pending) {
+        return -1.0f; // Run again next frame
+    }
+    g_dispatch_scheduled = false;
+    return 0.0f;      // Idle until EnqueueCommand schedules us again
+}
+
+// Copy an int array into a dataref array read request
+static int CopyIntArray(const int* values, int count, int* outValues, int inOffset, int inMax)
+{
+    if (outValues == NULL) {
+        return count;
+    }
+    if (inOffset < 0 || inOffset >= count) {
+        return 0;
+    }
+    int copied = (count - inOffset < inMax) ? count - inOffset : inMax;
+    memcpy(outValues, values + inOffset, copied * sizeof(int));
+    return copied;
+}
+
+static int GetCommandsPerFrame(void* /*inRefcon*/)
+{
+    return g_commands_per_frame;
+}
+
+static void SetCommandsPerFrame(void* /*inRefcon*/, int inValue)
+{
+    if (inValue < 1) inValue = 1;
+    if (inValue > MAX_COMMANDS_PER_FRAME) inValue = MAX_COMMANDS_PER_FRAME;
+    g_commands_per_frame = inValue;
+}
+
+static int GetHoldKeys(void* /*inRefcon*/)
+{
+    return g_hold_keys;
+}
+
+static void SetHoldKeys(void* /*inRefcon*/, int inValue)
+{
+    g_hold_keys = (inValue != 0) ? 1 : 0;
+    if (g_hold_keys == 0) ReleaseHeldKeys();
+}
+
+static int GetQueueDepth(void* /*inRefcon*/, int* outValues, int inOffset, int inMax)
+{
+    int depth[2] = {(int)g_command_queues[0].Size() + CountScratchpadWrite(1),
+                    (int)g_command_queues[1].Size() + CountScratchpadWrite(2)};
+    return CopyIntArray(depth, 2, outValues, inOffset, inMax);
+}
+
+static int GetQueueArray(void* inRefcon, int* outValues, int inOffset, int inMax)
+{
+    return CopyIntArray((const int*)inRefcon, 2, outValues, inOffset, inMax);
+}
+
+// Work left for ResolveFlightLoop: commands to look up, plus 1 while a cached detection is unverified
+static int GetLookupsPending(void* /*inRefcon*/)
+{
+    int pending = g_verify_detection ? 1 : 0;
+    for (int side = 0; side < 2; side++) {
+        for (int bit = 0; bit < BUTTON_COUNT; bit++) {
+            if (g_pending_commands[side] & (1ULL << bit)) pending++;
+        }
+    }
+    return pending;
+}
+
+// Publish queue tuning and observability datarefs (arrays are [Captain, FO])
+static void RegisterQueueDataRefs()
+{
+    g_queue_datarefs[0] = XPLMRegisterDataAccessor("Universal/FMC_Keyboard/queue/commands_per_frame", xplmType_Int, 1,
+                                                   GetCommandsPerFrame, SetCommandsPerFrame, NULL, NULL, NULL, NULL,
+                                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    g_queue_datarefs[1] = XPLMRegisterDataAccessor("Universal/FMC_Keyboard/queue/depth", xplmType_IntArray, 0,
+                                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                                   GetQueueDepth, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    g_queue_datarefs[2] = XPLMRegisterDataAccessor("Universal/FMC_Keyboard/queue/high_water", xplmType_IntArray, 0,
+                                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                                   GetQueueArray, NULL, NULL, NULL, NULL, NULL, g_queue_high_water, NULL);
+    g_queue_datarefs[3] = XPLMRegisterDataAccessor("Universal/FMC_Keyboard/queue/overflows", xplmType_IntArray, 0,
+                                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                                   GetQueueArray, NULL, NULL, NULL, NULL, NULL, g_queue_overflows, NULL);
+    g_queue_datarefs[4] = XPLMRegisterDataAccessor("Universal/FMC_Keyboard/queue/hold_keys", xplmType_Int, 1,
+                                                   GetHoldKeys, SetHoldKeys, NULL, NULL, NULL, NULL,
+                                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    g_queue_datarefs[5] = XPLMRegisterDataAccessor("Universal/FMC_Keyboard/queue/lookups_pending", xplmType_Int, 0,
+                                                   GetLookupsPending, NULL, NULL, NULL, NULL, NULL,
+                                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+}
+
+static void UnregisterQueueDataRefs()
+{
+    for (size_t i = 0; i < sizeof(g_queue_datarefs) / sizeof(g_queue_datarefs[0]); i++) {
+        if (g_queue_datarefs[i] != NULL) {
+            XPLMUnregisterDataAccessor(g_queue_datarefs[i]);
+            g_queue_datarefs[i] = NULL;
+        }
+    }
+}
+
+// Monotonic time for duration measurements
+static int64_t MonotonicNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Count a duration in its log2 histogram bucket (see STATS_HISTOGRAM_BUCKETS)
+static void RecordDuration(int* histogram, int64_t nanoseconds)
+{
+    int bucket = 0;
+    for (int64_t limit = 128; nanoseconds >= limit && bucket < STATS_HISTOGRAM_BUCKETS - 1; limit <<= 1) {
+        bucket++;
+    }
+    histogram[bucket]++;
+}
+
+static int GetStatCounter(void* inRefcon)
+{
+    return *(const int*)inRefcon;
+}
+
+static int GetStatHistogram(void* inRefcon, int* outValues, int inOffset, int inMax)
+{
+    return CopyIntArray((const int*)inRefcon, STATS_HISTOGRAM_BUCKETS, outValues, inOffset, inMax);
+}
+
+// Publish the performance counters and duration histograms (all read-only)
+static void RegisterStatsDataRefs()
+{
+    struct { const char* name; int* counter; } counters[] = {
+        {"Universal/FMC_Keyboard/stats/keys_seen", &g_stats.keys_seen},
+        {"Universal/FMC_Keyboard/stats/keys_consumed", &g_stats.keys_consumed},
+        {"Universal/FMC_Keyboard/stats/keys_passed", &g_stats.keys_passed},
+        {"Universal/FMC_Keyboard/stats/find_command_misses", &g_stats.find_command_misses},
+        {"Universal/FMC_Keyboard/stats/detection_runs", &g_stats.detection_runs},
+        {"Universal/FMC_Keyboard/stats/key_repeats_dropped", &g_stats.key_repeats_dropped},
+    };
+    for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+        g_stats_datarefs[i] = XPLMRegisterDataAccessor(counters[i].name, xplmType_Int, 0,
+                                                       GetStatCounter, NULL, NULL, NULL, NULL, NULL,
+                                                       NULL, NULL, NULL, NULL, NULL, NULL, counters[i].counter, NULL);
+    }
+    g_stats_datarefs[6] = XPLMRegisterDataAccessor("Universal/FMC_Keyboard/stats/key_callback_ns_histogram", xplmType_IntArray, 0,
+                                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                                   GetStatHistogram, NULL, NULL, NULL, NULL, NULL, g_stats.key_callback_ns, NULL);
+    g_stats_datarefs[7] = XPLMRegisterDataAccessor("Universal/FMC_Keyboard/stats/draw_status_ns_histogram", xplmType_IntArray, 0,
+                                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                                   GetStatHistogram, NULL, NULL, NULL, NULL, NULL, g_stats.draw_status_ns, NULL);
+}
+
+static void UnregisterStatsDataRefs()
+{
+    for (size_t i = 0; i < sizeof(g_stats_datarefs) / sizeof(g_stats_datarefs[0]); i++) {
+        if (g_stats_datarefs[i] != NULL) {
+            XPLMUnregisterDataAccessor(g_stats_datarefs[i]);
+            g_stats_datarefs[i] = NULL;
+        }
+    }
+}
+
+// Record a completed span (start_ns to now) if tracing is on
+static void TraceSpan(const char* name, int64_t start_ns, const char* arg_name, int arg)
+{
+    if (!g_trace.IsEnabled()) {
+        return;
+    }
+    TraceEvent event;
+    event.name = name;
+    event.arg_name = arg_name;
+    event.start_ns = start_ns;
+    event.duration_ns = MonotonicNanoseconds() - start_ns;
+    event.arg = arg;
+    event.frame = XPLMGetCycleNumber();
+    g_trace.Record(event);
+}
+
+// Start or stop the trace; the file goes in the folder that holds the plugin binary
+static void ToggleTrace()
+{
+    if (g_trace.IsEnabled()) {
+        long long dropped = g_trace.Stop();
+        LOG_INFO("Trace stopped (%lld events dropped)", dropped);
+        return;
+    }
+    
+    char path[256];
+    GetPluginFilePath("FMCKeyboard_trace.json", path, sizeof(path));
+    if (g_trace.Start(path)) {
+        LOG_INFO("Trace started: %s", path);
+    } else {
+        LOG_ERROR("Failed to open trace file %s", path);
+    }
+}
+
+// Path of a file in the folder that holds the plugin binary
+static void GetPluginFilePath(const char* file_name, char* path, size_t size)
+{
+    char plugin_path[256];   // XPLMGetPluginInfo writes at most 256 bytes
+    XPLMGetPluginInfo(XPLMGetMyID(), NULL, plugin_path, NULL, NULL);
+    char* separator = strrchr(plugin_path, '/');
+#if IBM
+    char* backslash = strrchr(plugin_path, '\\');
+    if (backslash > separator) separator = backslash;
+#endif
+    int folder_length = separator ? (int)(separator - plugin_path + 1) : 0;
+    snprintf(path, size, "%.*s%s", folder_length, plugin_path, file_name);
+}
+
+// Start or stop writing key events to FMCKeyboard_session.bin
+static void ToggleSessionRecording()
+{
+    if (g_session_file != NULL) {
+        fclose(g_session_file);
+        g_session_file = NULL;
+        LOG_INFO("Session recording stopped (%d key events)", g_session_records);
+        return;
+    }
+    
+    char path[256];
+    GetPluginFilePath("FMCKeyboard_session.bin", path, sizeof(path));
+    g_session_file = fopen(path, "wb");
+    if (g_session_file == NULL) {
+        LOG_ERROR("Failed to open session recording %s", path);
+        return;
+    }
+    setvbuf(g_session_file, g_session_buffer, _IOFBF, sizeof(g_session_buffer));
+    
+    FMCSessionHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FMC_SESSION_MAGIC, sizeof(FMC_SESSION_MAGIC));
+    header.version = FMC_SESSION_VERSION;
+    header.record_size = sizeof(FMCSessionRecord);
+    fwrite(&header, sizeof(header), 1, g_session_file);
+    
+    g_session_start_ns = MonotonicNanoseconds();
+    g_session_records = 0;
+    LOG_INFO("Session recording started: %s", path);
+}
+
+// Append one key event to the session recording
+static void RecordSessionEvent(int64_t time_ns, char inChar, XPLMKeyFlags inFlags, unsigned char virtualKey, ButtonId button, int result)
+{
+    FMCSessionRecord record;
+    record.time_ns = time_ns - g_session_start_ns;
+    record.virtual_key = virtualKey;
+    record.flags = (uint8_t)inFlags;
+    record.character = (int8_t)inChar;
+    record.aircraft = g_current_profile ? g_current_profile->session_code : (uint8_t)FMC_SESSION_AIRCRAFT_UNKNOWN;
+    record.side = (uint8_t)g_fmc_side;
+    record.button = (uint8_t)button;
+    record.consumed = (result == 0) ? 1 : 0;
+    record.reserved = 0;
+    if (fwrite(&record, sizeof(record), 1, g_session_file) == 1) {
+        g_session_records++;
+    }
+}
+
+// Convert injected text to logical buttons in one pass and queue it on the requested side
+static void HandleTextMessage(FMCKeyboardTextMessage* message)
+{
+    if (message == NULL || message->structSize < (int)sizeof(FMCKeyboardTextMessage) || message->text == NULL) {
+        LOG_WARNING("Ignoring malformed text injection message");
+        return;
+    }
+    message->outAccepted = 0;
+    message->outRejected = 0;
+    int64_t start = MonotonicNanoseconds();
+    
+    int length = (message->length >= 0) ? message->length : (int)strlen(message->text);
+    if (!IsSupportedAircraft()) {
+        message->outRejected = length;
+        return;
+    }
+    
+    // Single-FMC aircraft (SR22) only have side 1
+    int side = (message->side == FMC_KEYBOARD_SIDE_ACTIVE) ? g_fmc_side : message->side;
+    if (side != 1 && side != 2) {
+        LOG_WARNING("Ignoring text injection message with invalid side");
+        message->outRejected = length;
+        return;
+    }
+    if (!g_current_profile->has_side_specific_fmc) {
+        side = 1;
+    }
+    
+    const unsigned char* text = (const unsigned char*)message->text;
+    for (int i = 0; i < length; i++) {
+        unsigned char character = text[i];
+        if (character >= 0x80) {
+            // Non-ASCII UTF-8 sequence: count the code point once, skip its continuation bytes
+            while (i + 1 < length && (text[i + 1] & 0xC0) == 0x80) i++;
+            message->outRejected++;
+            continue;
+        }
+        
+        ButtonId button = g_character_table.buttons[character];
+        bool accepted = false;
+        if (button == BUTTON_MINUS || button == BUTTON_PLUS) {
+            accepted = HandlePlusMinusKey(side, button);
+        } else if (button != BUTTON_NONE) {
+            XPLMCommandRef command = GetKeyCommand(side, button);
+            accepted = (command != NULL) && (BufferScratchpadKey(side, button) || EnqueueCommand(side, command));
+            if (accepted) NoteScratchpadKey(side, button);
+        }
+        
+        if (accepted) message->outAccepted++; else message->outRejected++;
     }
+    TraceSpan("HandleTextMessage", start, "accepted", message->outAccepted);
 }
 
 // Captain command handler
@@ -642,10 +2091,7 @@ static int CaptainCommandHandler(XPLMCommandRef /*inCommand*/, XPLMCommandPhase
 static int FOCommandHandler(XPLMCommandRef /*inCommand*/, XPLMCommandPhase inPhase, void* /*inRefcon*/)
 {
     if (inPhase == xplm_CommandBegin) {
-        // Update current config first
-        IsSupportedAircraft();
-        
-        if (g_current_config && !g_current_config->has_side_specific_fmc) {
+        if (g_current_profile && !g_current_profile->has_side_specific_fmc) {
             // For aircraft without side-specific FMCs like SR22, FO command acts same as Captain command
             ToggleKeyboardInput(1); // Use single FMC/GPS
         } else {
@@ -656,6 +2102,24 @@ static int FOCommandHandler(XPLMCommandRef /*inCommand*/, XPLMCommandPhase inPha
     return 0;
 }
 
+// Trace toggle command handler
+static int TraceCommandHandler(XPLMCommandRef /*inCommand*/, XPLMCommandPhase inPhase, void* /*inRefcon*/)
+{
+    if (inPhase == xplm_CommandBegin) {
+        ToggleTrace();
+    }
+    return 0;
+}
+
+// Session recording toggle command handler
+static int RecordingCommandHandler(XPLMCommandRef /*inCommand*/, XPLMCommandPhase inPhase, void* /*inRefcon*/)
+{
+    if (inPhase == xplm_CommandBegin) {
+        ToggleSessionRecording();
+    }
+    return 0;
+}
+
 // Plugin entry point
 PLUGIN_API int XPluginStart(char* outName, char* outSig, char* outDesc)
 {
@@ -663,30 +2127,72 @@ PLUGIN_API int XPluginStart(char* outName, char* outSig, char* outDesc)
     strcpy(outSig, PLUGIN_SIG);
     strcpy(outDesc, PLUGIN_DESC);
     
-    // Initialize key mappings
-    InitializeKeyMappings();
+    // POSIX/Windows paths from XPLMGetPluginInfo (trace file location)
+    XPLMEnableFeature("XPLM_USE_NATIVE_PATHS", 1);
+    
+    // Log drain flight loop first, so everything below logs through the ring
+    XPLMCreateFlightLoop_t log_loop_params;
+    memset(&log_loop_params, 0, sizeof(log_loop_params));
+    log_loop_params.structSize = sizeof(log_loop_params);
+    log_loop_params.phase = xplm_FlightLoop_Phase_AfterFlightModel;
+    log_loop_params.callbackFunc = LogFlightLoop;
+    log_loop_params.refcon = NULL;
+    g_log_flight_loop = XPLMCreateFlightLoop(&log_loop_params);
     
-    // Find aircraft ICAO dataref
+    // Find the aircraft datarefs detection matches on
     g_icao_dataref = XPLMFindDataRef("sim/aircraft/view/acf_ICAO");
+    g_author_dataref = XPLMFindDataRef("sim/aircraft/view/acf_author");
+    g_studio_dataref = XPLMFindDataRef("sim/aircraft/view/acf_studio");
+    
+    // Built-in aircraft plus profiles/*.profile
+    LoadAircraftProfiles();
+    
+    // Command availability remembered from earlier sessions, verified by a flight loop
+    char cache_path[512];
+    GetPluginFilePath(FMC_AVAILABILITY_FILE, cache_path, sizeof(cache_path));
+    g_availability_cache.Load(cache_path);
+    XPLMCreateFlightLoop_t resolve_loop_params;
+    memset(&resolve_loop_params, 0, sizeof(resolve_loop_params));
+    resolve_loop_params.structSize = sizeof(resolve_loop_params);
+    resolve_loop_params.phase = xplm_FlightLoop_Phase_BeforeFlightModel;
+    resolve_loop_params.callbackFunc = ResolveFlightLoop;
+    resolve_loop_params.refcon = NULL;
+    g_resolve_flight_loop = XPLMCreateFlightLoop(&resolve_loop_params);
     
     // Create custom commands
     g_captain_command = XPLMCreateCommand("Universal/FMC_Keyboard/Toggle_Keyboard_Input_Captain", 
                                         "Toggle FMC Keyboard Input (Captain)");
     g_fo_command = XPLMCreateCommand("Universal/FMC_Keyboard/Toggle_Keyboard_Input_FO", 
                                    "Toggle FMC Keyboard Input (FO)");
+    g_trace_command = XPLMCreateCommand("Universal/FMC_Keyboard/Toggle_Trace",
+                                      "Start/stop FMC Keyboard performance trace");
+    g_recording_command = XPLMCreateCommand("Universal/FMC_Keyboard/Toggle_Recording",
+                                          "Start/stop FMC Keyboard session recording");
     
     // Register command handlers
     XPLMRegisterCommandHandler(g_captain_command, CaptainCommandHandler, 1, NULL);
     XPLMRegisterCommandHandler(g_fo_command, FOCommandHandler, 1, NULL);
+    XPLMRegisterCommandHandler(g_trace_command, TraceCommandHandler, 1, NULL);
+    XPLMRegisterCommandHandler(g_recording_command, RecordingCommandHandler, 1, NULL);
     
-    // Register key callback
-    XPLMRegisterKeySniffer(KeyCallback, 1, NULL);
+    // The key sniffer is registered on demand in ToggleKeyboardInput
+    
+    // Create the paced dispatch flight loop (scheduled only while commands are queued)
+    XPLMCreateFlightLoop_t flight_loop_params;
+    memset(&flight_loop_params, 0, sizeof(flight_loop_params));
+    flight_loop_params.structSize = sizeof(flight_loop_params);
+    flight_loop_params.phase = xplm_FlightLoop_Phase_BeforeFlightModel;
+    flight_loop_params.callbackFunc = DispatchFlightLoop;
+    flight_loop_params.refcon = NULL;
+    g_dispatch_flight_loop = XPLMCreateFlightLoop(&flight_loop_params);
+    RegisterQueueDataRefs();
+    RegisterStatsDataRefs();
     
     // Create status window using modern X-Plane window system
     CreateStatusWindow();
     UpdateStatusWindow();  // Set initial visibility
     
-    LogMessage("Plugin initialized successfully");
+    LOG_INFO("Plugin initialized successfully");
     
     return 1;
 }
@@ -698,11 +2204,25 @@ PLUGIN_API void XPluginStop(void)
     if (g_status_window != NULL) {
         XPLMDestroyWindow(g_status_window);
         g_status_window = NULL;
-        LogMessage("Status window destroyed");
+        LOG_INFO("Status window destroyed");
     }
     
     // Unregister callbacks
-    XPLMUnregisterKeySniffer(KeyCallback, 1, NULL);
+    SetKeySnifferRegistered(false);
+    
+    // Stop paced dispatch
+    ClearCommandQueues();
+    if (g_dispatch_flight_loop != NULL) {
+        XPLMDestroyFlightLoop(g_dispatch_flight_loop);
+        g_dispatch_flight_loop = NULL;
+        g_dispatch_scheduled = false;
+    }
+    UnregisterQueueDataRefs();
+    UnregisterStatsDataRefs();
+    if (g_resolve_flight_loop != NULL) {
+        XPLMDestroyFlightLoop(g_resolve_flight_loop);
+        g_resolve_flight_loop = NULL;
+    }
     
     // Unregister command handlers
     if (g_captain_command) {
@@ -711,23 +2231,87 @@ PLUGIN_API void XPluginStop(void)
     if (g_fo_command) {
         XPLMUnregisterCommandHandler(g_fo_command, FOCommandHandler, 1, NULL);
     }
+    if (g_trace_command) {
+        XPLMUnregisterCommandHandler(g_trace_command, TraceCommandHandler, 1, NULL);
+    }
+    if (g_recording_command) {
+        XPLMUnregisterCommandHandler(g_recording_command, RecordingCommandHandler, 1, NULL);
+    }
+    
+    // Flush and close the trace and session files if they are being written
+    if (g_trace.IsEnabled()) {
+        ToggleTrace();
+    }
+    if (g_session_file != NULL) {
+        ToggleSessionRecording();
+    }
+    
+    // Stop watching profiles/ and release the profile table (unmaps profiles.pack)
+    g_profile_watcher.Stop();
+    if (g_profile_reload_flight_loop != NULL) {
+        XPLMDestroyFlightLoop(g_profile_reload_flight_loop);
+        g_profile_reload_flight_loop = NULL;
+    }
+    g_current_profile = nullptr;
+    g_profile_pack = nullptr;
+    delete g_profile_snapshot;
+    g_profile_snapshot = nullptr;
+    
+    LOG_INFO("Plugin stopped");
     
-    LogMessage("Plugin stopped");
+    // Write out everything still queued; later messages are written immediately
+    FlushLog(true);
+    if (g_log_flight_loop != NULL) {
+        XPLMDestroyFlightLoop(g_log_flight_loop);
+        g_log_flight_loop = NULL;
+        g_log_scheduled = false;
+    }
 }
 
 PLUGIN_API void XPluginDisable(void)
 {
     // Disable keyboard input when plugin is disabled
     g_toggled = 0;
+    SetKeySnifferRegistered(false);
+    ClearAircraft();
     UpdateStatusWindow();  // Hide status window when disabled
+    SaveCommandAvailability();
 }
 
 PLUGIN_API int XPluginEnable(void)
 {
+    // The user aircraft may already be loaded (e.g. plugin re-enabled from the Plugin Admin)
+    RefreshAircraft("plugin enabled");
     return 1;
 }
 
-PLUGIN_API void XPluginReceiveMessage(XPLMPluginID /*inFrom*/, int /*inMsg*/, void* /*inParam*/)
+PLUGIN_API void XPluginReceiveMessage(XPLMPluginID /*inFrom*/, int inMsg, void* inParam)
 {
-    // Handle plugin messages if needed
+    // Bulk text injection from other plugins (see FMCKeyboardAPI.h)
+    if (inMsg == FMC_KEYBOARD_MSG_TYPE_TEXT) {
+        HandleTextMessage((FMCKeyboardTextMessage*)inParam);
+        return;
+    }
+    
+    // Only the user aircraft matters; AI planes send the same messages with their index
+    if ((intptr_t)inParam != XPLM_USER_AIRCRAFT) {
+        return;
+    }
+    
+    switch (inMsg) {
+        case XPLM_MSG_PLANE_LOADED:
+            RefreshAircraft("plane loaded");
+            UpdateStatusWindow();
+            break;
+        case XPLM_MSG_LIVERY_LOADED:
+            RefreshAircraft("livery loaded");
+            UpdateStatusWindow();
+            break;
+        case XPLM_MSG_PLANE_UNLOADED:
+            ClearAircraft();
+            UpdateStatusWindow();
+            break;
+        default:
+            break;
+    }
 }
@@ -0,0 +1,317 @@
+// fmc_dispatch_bench - keystroke dispatch micro-benchmarks on the XPLM stand-in
+//
+// Usage: fmc_dispatch_bench [--plugin lin.xpl] [--iterations N] [--repeats N]
+//                           [--output results.json] [--baseline baseline.json] [--threshold 0.25]
+//
+// Measures nanoseconds per key event delivered to the plugin's key sniffer for every
+// supported aircraft and FMC side (a key-down is timed together with its release), plus the XPLMFindCommand / XPLMGetDatab calls and
+// commands fired per key. Results are written as JSON. With --baseline, each scenario
+// is compared against a previous run: the exit code is 1 if any scenario got slower than
+// the threshold allows or started making more XPLM lookups per key.
+
+#include "PluginHost.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifndef FMC_KEYBOARD_PLUGIN_PATH
+#define FMC_KEYBOARD_PLUGIN_PATH "lin.xpl"
+#endif
+
+// Events between untimed queue drains; keeps the plugin's command queues from overflowing
+static const int BATCH_SIZE = 128;
+
+struct ScenarioResult {
+    std::string name;
+    double ns_per_call;
+    double find_command_per_key;
+    double get_datab_per_key;
+    double commands_per_key;
+};
+
+// One key event the scenario sends repeatedly (alternate_* is used on odd iterations)
+struct Scenario {
+    const char* name;
+    AircraftPreset aircraft;
+    int side;
+    bool input_enabled;
+    unsigned char virtual_key;
+    XPLMKeyFlags flags;
+    unsigned char alternate_virtual_key;
+    XPLMKeyFlags alternate_flags;
+};
+
+static double NowNs()
+{
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static ScenarioResult RunScenario(PluginHost& host, const Scenario& scenario, int iterations, int repeats)
+{
+    host.LoadAircraft(scenario.aircraft);
+    if (scenario.input_enabled) {
+        host.ToggleInput(scenario.side);
+    }
+    host.RunUntilIdle();
+
+    std::vector<double> samples;
+    long long find_command = 0;
+    long long get_datab = 0;
+    long long commands = 0;
+
+    for (int repeat = 0; repeat < repeats; repeat++) {
+        double elapsed = 0.0;
+        for (int done = 0; done < iterations; ) {
+            int batch = std::min(BATCH_SIZE, iterations - done);
+
+            XPLMStub_ResetCounters();
+            double start = NowNs();
+            for (int i = 0; i < batch; i++) {
+                bool alternate = ((done + i) & 1) && scenario.alternate_virtual_key != 0;
+                unsigned char virtual_key = alternate ? scenario.alternate_virtual_key : scenario.virtual_key;
+                XPLMKeyFlags flags = alternate ? scenario.alternate_flags : scenario.flags;
+                host.SendKey(virtual_key, flags);
+                // Release every press, or the next one would be taken as an OS auto-repeat
+                if (flags & xplm_DownFlag) {
+                    host.SendKey(virtual_key, xplm_UpFlag);
+                }
+            }
+            elapsed += NowNs() - start;
+            find_command += XPLMStub_GetCounter(XPLMSTUB_FIND_COMMAND);
+            get_datab += XPLMStub_GetCounter(XPLMSTUB_GET_DATAB);
+
+            // Drain outside the timed region; count the commands the batch produced
+            XPLMStub_ClearCommandEvents();
+            host.RunUntilIdle();
+            commands += XPLMStub_CountCommandEvents();
+            done += batch;
+        }
+        samples.push_back(elapsed / iterations);
+    }
+
+    if (scenario.input_enabled) {
+        host.ToggleInput(scenario.side);
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double total_keys = (double)iterations * repeats;
+    ScenarioResult result;
+    result.name = scenario.name;
+    result.ns_per_call = samples[samples.size() / 2];   // Median of the repeats
+    result.find_command_per_key = find_command / total_keys;
+    result.get_datab_per_key = get_datab / total_keys;
+    result.commands_per_key = commands / total_keys;
+    return result;
+}
+
+static std::string ToJson(const std::vector<ScenarioResult>& results, int iterations, int repeats)
+{
+    std::string json = "{\n  \"benchmark\": \"fmc_dispatch\",\n";
+    char line[512];
+    snprintf(line, sizeof(line), "  \"iterations\": %d,\n  \"repeats\": %d,\n  \"results\": [\n", iterations, repeats);
+    json += line;
+    for (size_t i = 0; i < results.size(); i++) {
+        const ScenarioResult& r = results[i];
+        snprintf(line, sizeof(line),
+                 "    {\"name\": \"%s\", \"ns_per_call\": %.2f, \"find_command_per_key\": %.4f, "
+                 "\"get_datab_per_key\": %.4f, \"commands_per_key\": %.4f}%s\n",
+                 r.name.c_str(), r.ns_per_call, r.find_command_per_key, r.get_datab_per_key,
+                 r.commands_per_key, (i + 1 < results.size()) ? "," : "");
+        json += line;
+    }
+    json += "  ]\n}\n";
+    return json;
+}
+
+// Read a numeric field that follows `key` inside the object starting at `object`
+static bool ReadNumber(const char* object, const char* object_end, const char* key, double* out)
+{
+    const char* field = strstr(object, key);
+    if (field == nullptr || field >= object_end) return false;
+    const char* colon = strchr(field, ':');
+    if (colon == nullptr || colon >= object_end) return false;
+    *out = strtod(colon + 1, nullptr);
+    return true;
+}
+
+// Minimal reader for the JSON this tool writes: one result object per line
+static bool LoadBaseline(const char* path, std::vector<ScenarioResult>* out)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) return false;
+    std::string text;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, read);
+    }
+    fclose(file);
+
+    const char* cursor = text.c_str();
+    while ((cursor = strstr(cursor, "{\"name\": \"")) != nullptr) {
+        const char* name_start = cursor + strlen("{\"name\": \"");
+        const char* name_end = strchr(name_start, '"');
+        const char* object_end = strchr(name_start, '}');
+        if (name_end == nullptr || object_end == nullptr) break;
+
+        ScenarioResult result;
+        result.name.assign(name_start, name_end);
+        if (ReadNumber(name_end, object_end, "\"ns_per_call\"", &result.ns_per_call) &&
+            ReadNumber(name_end, object_end, "\"find_command_per_key\"", &result.find_command_per_key) &&
+            ReadNumber(name_end, object_end, "\"get_datab_per_key\"", &result.get_datab_per_key) &&
+            ReadNumber(name_end, object_end, "\"commands_per_key\"", &result.commands_per_key)) {
+            out->push_back(result);
+        }
+        cursor = object_end;
+    }
+    return true;
+}
+
+// Print a comparison table; returns the number of regressions
+static int CompareWithBaseline(const std::vector<ScenarioResult>& results, const std::vector<ScenarioResult>& baseline, double threshold)
+{
+    int regressions = 0;
+    fprintf(stderr, "%-36s %12s %12s %8s\n", "scenario", "baseline ns", "current ns", "change");
+    for (size_t i = 0; i < results.size(); i++) {
+        const ScenarioResult& current = results[i];
+        const ScenarioResult* previous = nullptr;
+        for (size_t j = 0; j < baseline.size(); j++) {
+            if (baseline[j].name == current.name) previous = &baseline[j];
+        }
+        if (previous == nullptr) {
+            fprintf(stderr, "%-36s %12s %12.1f %8s\n", current.name.c_str(), "-", current.ns_per_call, "new");
+            continue;
+        }
+
+        double change = (previous->ns_per_call > 0.0) ? current.ns_per_call / previous->ns_per_call - 1.0 : 0.0;
+        bool slower = change > threshold;
+        bool more_lookups = current.find_command_per_key > previous->find_command_per_key + 1e-9 ||
+                            current.get_datab_per_key > previous->get_datab_per_key + 1e-9;
+        fprintf(stderr, "%-36s %12.1f %12.1f %+7.1f%%%s%s\n", current.name.c_str(), previous->ns_per_call,
+                current.ns_per_call, change * 100.0, slower ? "  SLOWER" : "", more_lookups ? "  MORE LOOKUPS" : "");
+        if (slower || more_lookups) regressions++;
+    }
+    return regressions;
+}
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+            "Usage: fmc_dispatch_bench [--plugin lin.xpl] [--iterations N] [--repeats N]\n"
+            "                          [--output results.json] [--baseline baseline.json] [--threshold 0.25]\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* plugin_path = FMC_KEYBOARD_PLUGIN_PATH;
+    const char* output_path = nullptr;
+    const char* baseline_path = nullptr;
+    int iterations = 20000;
+    int repeats = 5;
+    double threshold = 0.25;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (strcmp(arg, "--plugin") == 0 && has_value) {
+            plugin_path = argv[++i];
+        } else if (strcmp(arg, "--iterations") == 0 && has_value) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(arg, "--repeats") == 0 && has_value) {
+            repeats = atoi(argv[++i]);
+        } else if (strcmp(arg, "--output") == 0 && has_value) {
+            output_path = argv[++i];
+        } else if (strcmp(arg, "--baseline") == 0 && has_value) {
+            baseline_path = argv[++i];
+        } else if (strcmp(arg, "--threshold") == 0 && has_value) {
+            threshold = atof(argv[++i]);
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (iterations < 1 || repeats < 1) {
+        PrintUsage();
+        return 2;
+    }
+
+    PluginHost host;
+    std::string error;
+    RemoveCommandCache(plugin_path);   // Start cold, whatever earlier runs left behind
+    if (!host.Load(plugin_path, &error)) {
+        fprintf(stderr, "Failed to load %s: %s\n", plugin_path, error.c_str());
+        return 1;
+    }
+
+    const XPLMKeyFlags down = xplm_DownFlag;
+    std::vector<Scenario> scenarios;
+    const struct { AircraftPreset preset; int sides; } aircraft[] = {
+        {AIRCRAFT_PRESET_ZIBO_737, 2},
+        {AIRCRAFT_PRESET_DEFAULT_737, 2},
+        {AIRCRAFT_PRESET_DEFAULT_A330, 2},
+        {AIRCRAFT_PRESET_DEFAULT_SR22, 1},
+    };
+    static std::vector<std::string> names;   // Scenario keeps const char* into these
+    names.reserve(64);
+    for (size_t a = 0; a < sizeof(aircraft) / sizeof(aircraft[0]); a++) {
+        for (int side = 1; side <= aircraft[a].sides; side++) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s/side%d/letter", AircraftPresetName(aircraft[a].preset), side);
+            names.push_back(name);
+            scenarios.push_back({names.back().c_str(), aircraft[a].preset, side, true, XPLM_VK_A, down, 0, 0});
+            snprintf(name, sizeof(name), "%s/side%d/enter", AircraftPresetName(aircraft[a].preset), side);
+            names.push_back(name);
+            scenarios.push_back({names.back().c_str(), aircraft[a].preset, side, true, XPLM_VK_RETURN, down, 0, 0});
+        }
+    }
+    scenarios.push_back({"zibo/disabled", AIRCRAFT_PRESET_ZIBO_737, 1, false, XPLM_VK_A, down, 0, 0});
+    scenarios.push_back({"zibo/key_up", AIRCRAFT_PRESET_ZIBO_737, 1, true, XPLM_VK_A, xplm_UpFlag, 0, 0});
+    scenarios.push_back({"zibo/modifier_rejected", AIRCRAFT_PRESET_ZIBO_737, 1, true, XPLM_VK_A, down | xplm_ControlFlag, 0, 0});
+    scenarios.push_back({"zibo/shift_equal_plus", AIRCRAFT_PRESET_ZIBO_737, 1, true, XPLM_VK_EQUAL, down | xplm_ShiftFlag, 0, 0});
+    scenarios.push_back({"zibo/plus_minus_toggle", AIRCRAFT_PRESET_ZIBO_737, 1, true,
+                         XPLM_VK_MINUS, down, XPLM_VK_EQUAL, down | xplm_ShiftFlag});
+    scenarios.push_back({"b738/plus_minus_toggle", AIRCRAFT_PRESET_DEFAULT_737, 2, true,
+                         XPLM_VK_SUBTRACT, down, XPLM_VK_ADD, down});
+    scenarios.push_back({"sr22/unsupported_slash", AIRCRAFT_PRESET_DEFAULT_SR22, 1, true, XPLM_VK_SLASH, down, 0, 0});
+    scenarios.push_back({"sr22/unsupported_minus", AIRCRAFT_PRESET_DEFAULT_SR22, 1, true, XPLM_VK_MINUS, down, 0, 0});
+    scenarios.push_back({"zibo/unmapped_key", AIRCRAFT_PRESET_ZIBO_737, 1, true, XPLM_VK_F1, down, 0, 0});
+
+    std::vector<ScenarioResult> results;
+    for (size_t i = 0; i < scenarios.size(); i++) {
+        results.push_back(RunScenario(host, scenarios[i], iterations, repeats));
+    }
+    host.Unload();
+
+    std::string json = ToJson(results, iterations, repeats);
+    if (output_path != nullptr) {
+        FILE* file = fopen(output_path, "wb");
+        if (file == nullptr) {
+            fprintf(stderr, "Cannot write %s\n", output_path);
+            return 1;
+        }
+        fputs(json.c_str(), file);
+        fclose(file);
+    } else {
+        fputs(json.c_str(), stdout);
+    }
+
+    if (baseline_path != nullptr) {
+        std::vector<ScenarioResult> baseline;
+        if (!LoadBaseline(baseline_path, &baseline)) {
+            fprintf(stderr, "Cannot read baseline %s\n", baseline_path);
+            return 1;
+        }
+        int regressions = CompareWithBaseline(results, baseline, threshold);
+        if (regressions > 0) {
+            fprintf(stderr, "%d scenario(s) regressed beyond %.0f%%\n", regressions, threshold * 100.0);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,307 @@
+// Plugin host for the headless XPLM stand-in
+
+#include "PluginHost.h"
+
+#include "XPLMDataAccess.h"
+#include "XPLMPlanes.h"
+#include "XPLMPlugin.h"
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+struct AircraftPresetInfo {
+    const char* name;
+    const char* icao;
+    const char* description;
+    const char* acf_file;
+    const char* acf_folder;      // Relative to the X-Plane folder
+    const char* author;
+};
+
+const AircraftPresetInfo g_presets[AIRCRAFT_PRESET_COUNT] = {
+    {"none", "C172", "Unsupported aircraft", "Cessna_172SP.acf", "Aircraft/Laminar Research/Cessna 172 SP", "Laminar Research"},
+    {"zibo", "B738", "ZIBO 737", "b738.acf", "Aircraft/B737-800X", "Zibo"},
+    {"b738", "B738", "Default 737", "b738.acf", "Aircraft/Laminar Research/Boeing 737-800", "Laminar Research"},
+    {"a330", "A330", "Default A330", "A330.acf", "Aircraft/Laminar Research/Airbus A330-300", "Laminar Research"},
+    {"sr22", "SR22", "Default SR22", "Cirrus_SR22.acf", "Aircraft/Laminar Research/Cirrus SR22", "Laminar Research"},
+};
+
+// Publish the preset as the user aircraft (ICAO, .acf file and author), without commands
+void SetAircraftIdentity(AircraftPreset preset)
+{
+    const AircraftPresetInfo& info = g_presets[preset];
+    char path[512];
+    snprintf(path, sizeof(path), "/X-Plane 12/%s/%s", info.acf_folder, info.acf_file);
+    XPLMStub_SetDatab("sim/aircraft/view/acf_ICAO", info.icao, (int)strlen(info.icao) + 1, 0);
+    XPLMStub_SetDatab("sim/aircraft/view/acf_author", info.author, (int)strlen(info.author) + 1, 0);
+    XPLMStub_SetAircraftModel(info.acf_file, path);
+}
+
+// Key suffixes as the real aircraft name them (deliberately not shared with the plugin)
+const char* const g_zibo_keys[] = {
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+    "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M",
+    "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z",
+    "clr", "SP", "del", "ent", "slash", "period", "minus"
+};
+
+const char* const g_default_fms_keys[] = {
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+    "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m",
+    "n", "o", "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z",
+    "clear", "space", "delete", "enter", "slash", "period", "minus"
+};
+
+const char* const g_gcu478_keys[] = {
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+    "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M",
+    "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z",
+    "clr", "spc", "bksp", "ent", "dot"
+};
+
+template <size_t N>
+void ForEachCommand(const char* const (&keys)[N], const char* format, void (*action)(const char*, int), int arg)
+{
+    char name[128];
+    for (size_t i = 0; i < N; i++) {
+        snprintf(name, sizeof(name), format, keys[i]);
+        action(name, arg);
+    }
+}
+
+// Apply action to every command the preset's aircraft provides
+void ForEachPresetCommand(AircraftPreset preset, void (*action)(const char*, int), int arg)
+{
+    switch (preset) {
+        case AIRCRAFT_PRESET_ZIBO_737:
+            ForEachCommand(g_zibo_keys, "laminar/B738/button/fmc1_%s", action, arg);
+            ForEachCommand(g_zibo_keys, "laminar/B738/button/fmc2_%s", action, arg);
+            break;
+        case AIRCRAFT_PRESET_DEFAULT_737:
+        case AIRCRAFT_PRESET_DEFAULT_A330:
+            ForEachCommand(g_default_fms_keys, "sim/FMS/key_%s", action, arg);
+            ForEachCommand(g_default_fms_keys, "sim/FMS2/key_%s", action, arg);
+            break;
+        case AIRCRAFT_PRESET_DEFAULT_SR22:
+            ForEachCommand(g_gcu478_keys, "sim/GPS/gcu478/%s", action, arg);
+            break;
+        default:
+            break;
+    }
+}
+
+void AddCommand(const char* name, int /*arg*/)
+{
+    XPLMStub_AddCommand(name);
+}
+
+void SetCommandHidden(const char* name, int hidden)
+{
+    XPLMStub_SetCommandHidden(name, hidden);
+}
+
+} // namespace
+
+const char* AircraftPresetName(AircraftPreset preset)
+{
+    return (preset >= 0 && preset < AIRCRAFT_PRESET_COUNT) ? g_presets[preset].name : "?";
+}
+
+bool ParseAircraftPreset(const char* name, AircraftPreset* outPreset)
+{
+    for (int i = 0; i < AIRCRAFT_PRESET_COUNT; i++) {
+        if (strcmp(name, g_presets[i].name) == 0) {
+            *outPreset = (AircraftPreset)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RemoveCommandCache(const char* plugin_path)
+{
+    std::string path = plugin_path;
+    size_t separator = path.rfind('/');
+    path = (separator == std::string::npos) ? std::string() : path.substr(0, separator + 1);
+    path += "FMCKeyboard_commands.cache";
+    return remove(path.c_str()) == 0;
+}
+
+bool CharacterToKey(char character, unsigned char* outVirtualKey, XPLMKeyFlags* outFlags)
+{
+    *outFlags = xplm_DownFlag;
+    if (character >= '0' && character <= '9') {
+        *outVirtualKey = (unsigned char)(XPLM_VK_0 + (character - '0'));
+    } else if (character >= 'A' && character <= 'Z') {
+        *outVirtualKey = (unsigned char)(XPLM_VK_A + (character - 'A'));
+    } else if (character >= 'a' && character <= 'z') {
+        *outVirtualKey = (unsigned char)(XPLM_VK_A + (character - 'a'));
+    } else {
+        switch (character) {
+            case ' ':  *outVirtualKey = XPLM_VK_SPACE; break;
+            case '/':  *outVirtualKey = XPLM_VK_SLASH; break;
+            case '.':  *outVirtualKey = XPLM_VK_PERIOD; break;
+            case '-':  *outVirtualKey = XPLM_VK_MINUS; break;
+            case '+':  *outVirtualKey = XPLM_VK_EQUAL; *outFlags |= xplm_ShiftFlag; break;
+            case '\n': *outVirtualKey = XPLM_VK_RETURN; break;
+            case '\b': *outVirtualKey = XPLM_VK_BACK; break;
+            default:   return false;
+        }
+    }
+    return true;
+}
+
+PluginHost::PluginHost()
+    : m_handle(nullptr), m_start(nullptr), m_stop(nullptr), m_enable(nullptr),
+      m_disable(nullptr), m_receive_message(nullptr), m_aircraft(AIRCRAFT_PRESET_NONE)
+{
+}
+
+PluginHost::~PluginHost()
+{
+    Unload();
+}
+
+bool PluginHost::Load(const char* plugin_path, std::string* error)
+{
+    // The plugin's XPLM_64.so dependency resolves to the stub already loaded into this process
+    m_handle = dlopen(plugin_path, RTLD_NOW | RTLD_LOCAL);
+    if (m_handle == nullptr) {
+        if (error) *error = dlerror();
+        return false;
+    }
+
+    m_start = (StartFunc)dlsym(m_handle, "XPluginStart");
+    m_stop = (VoidFunc)dlsym(m_handle, "XPluginStop");
+    m_enable = (EnableFunc)dlsym(m_handle, "XPluginEnable");
+    m_disable = (VoidFunc)dlsym(m_handle, "XPluginDisable");
+    m_receive_message = (ReceiveMessageFunc)dlsym(m_handle, "XPluginReceiveMessage");
+    if (!m_start || !m_stop || !m_enable || !m_disable || !m_receive_message) {
+        if (error) *error = "plugin does not export all XPlugin* entry points";
+        dlclose(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+
+    char absolute_path[PATH_MAX];
+    XPLMStub_SetPluginPath(realpath(plugin_path, absolute_path) ? absolute_path : plugin_path);
+
+    // X-Plane always has a user aircraft
+    SetAircraftIdentity(m_aircraft);
+
+    char name[256] = "", signature[256] = "", description[256] = "";
+    if (!m_start(name, signature, description)) {
+        if (error) *error = "XPluginStart failed";
+        dlclose(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+    if (!m_enable()) {
+        if (error) *error = "XPluginEnable failed";
+        m_stop();
+        dlclose(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void PluginHost::Unload()
+{
+    if (m_handle == nullptr) return;
+    m_disable();
+    m_stop();
+    dlclose(m_handle);
+    m_handle = nullptr;
+}
+
+void PluginHost::SendMessage(int message, void* param, XPLMPluginID from)
+{
+    if (m_receive_message) {
+        m_receive_message(from, message, param);
+    }
+}
+
+void PluginHost::LoadAircraft(AircraftPreset preset)
+{
+    for (int i = 0; i < AIRCRAFT_PRESET_COUNT; i++) {
+        ForEachPresetCommand((AircraftPreset)i, SetCommandHidden, 1);
+    }
+    ForEachPresetCommand(preset, AddCommand, 0);
+
+    m_aircraft = preset;
+    SetAircraftIdentity(preset);
+    SendMessage(XPLM_MSG_PLANE_LOADED, (void*)(intptr_t)XPLM_USER_AIRCRAFT);
+}
+
+void PluginHost::UnloadAircraft()
+{
+    SendMessage(XPLM_MSG_PLANE_UNLOADED, (void*)(intptr_t)XPLM_USER_AIRCRAFT);
+    ForEachPresetCommand(m_aircraft, SetCommandHidden, 1);
+    m_aircraft = AIRCRAFT_PRESET_NONE;
+    XPLMStub_SetDatab("sim/aircraft/view/acf_ICAO", "", 1, 0);
+    XPLMStub_SetDatab("sim/aircraft/view/acf_author", "", 1, 0);
+    XPLMStub_SetAircraftModel("", "");
+}
+
+void PluginHost::ToggleInput(int side)
+{
+    XPLMStub_InvokeCommand(side == 2 ? "Universal/FMC_Keyboard/Toggle_Keyboard_Input_FO"
+                                     : "Universal/FMC_Keyboard/Toggle_Keyboard_Input_Captain");
+}
+
+int PluginHost::SendKey(unsigned char virtual_key, XPLMKeyFlags flags, char character)
+{
+    return XPLMStub_SendKey(character, flags, (char)virtual_key);
+}
+
+int PluginHost::PressKey(unsigned char virtual_key, XPLMKeyFlags flags, char character)
+{
+    XPLMKeyFlags modifiers = flags & (xplm_ShiftFlag | xplm_OptionAltFlag | xplm_ControlFlag);
+    int result = SendKey(virtual_key, modifiers | xplm_DownFlag, character);
+    SendKey(virtual_key, modifiers | xplm_UpFlag, character);
+    return result;
+}
+
+int PluginHost::TypeText(const char* text)
+{
+    int consumed = 0;
+    for (const char* c = text; *c != '\0'; c++) {
+        unsigned char virtual_key;
+        XPLMKeyFlags flags;
+        if (CharacterToKey(*c, &virtual_key, &flags) && PressKey(virtual_key, flags, *c) == 0) {
+            consumed++;
+        }
+    }
+    return consumed;
+}
+
+void PluginHost::RunFrames(int count, float seconds_per_frame)
+{
+    for (int i = 0; i < count; i++) {
+        XPLMStub_RunFrame(seconds_per_frame);
+    }
+}
+
+int PluginHost::RunUntilIdle(int max_frames, float seconds_per_frame)
+{
+    XPLMDataRef depth_dataref = XPLMFindDataRef("Universal/FMC_Keyboard/queue/depth");
+    XPLMDataRef lookups_dataref = XPLMFindDataRef("Universal/FMC_Keyboard/queue/lookups_pending");
+    int frames = 0;
+    while (frames < max_frames) {
+        int depth[2] = {0, 0};
+        bool queued = depth_dataref != nullptr && XPLMGetDatavi(depth_dataref, depth, 0, 2) == 2 && depth[0] + depth[1] > 0;
+        bool resolving = lookups_dataref != nullptr && XPLMGetDatai(lookups_dataref) > 0;
+        if (!queued && !resolving) {
+            break;
+        }
+        XPLMStub_RunFrame(seconds_per_frame);
+        frames++;
+    }
+    return frames;
+}
@@ -0,0 +1,88 @@
+// Plugin host for the headless XPLM stand-in
+//
+// Loads the real plugin binary with dlopen on top of the stub XPLM_64.so, calls its
+// entry points and plays the simulator side: aircraft loads, key presses and frames.
+// Shared by fmc_host and the other harness tools.
+
+#ifndef PLUGIN_HOST_H
+#define PLUGIN_HOST_H
+
+#define XPLM200 1
+#define XPLM210 1
+#define XPLM300 1
+#define XPLM301 1
+#include "XPLMDefs.h"
+#include "XPLMStub.h"
+
+#include <string>
+
+// Aircraft the stub can pretend to load, with the commands and ICAO each one provides
+enum AircraftPreset {
+    AIRCRAFT_PRESET_NONE = 0,      // No supported aircraft (ICAO "C172", no FMC commands)
+    AIRCRAFT_PRESET_ZIBO_737,
+    AIRCRAFT_PRESET_DEFAULT_737,
+    AIRCRAFT_PRESET_DEFAULT_A330,
+    AIRCRAFT_PRESET_DEFAULT_SR22,
+    AIRCRAFT_PRESET_COUNT
+};
+
+const char* AircraftPresetName(AircraftPreset preset);          // "zibo", "b738", "a330", "sr22", "none"
+bool ParseAircraftPreset(const char* name, AircraftPreset* outPreset);
+
+class PluginHost {
+public:
+    PluginHost();
+    ~PluginHost();
+
+    // dlopen the plugin and resolve its entry points; then XPluginStart + XPluginEnable
+    bool Load(const char* plugin_path, std::string* error);
+    // XPluginDisable + XPluginStop + dlclose
+    void Unload();
+    bool IsLoaded() const { return m_handle != nullptr; }
+
+    void SendMessage(int message, void* param, XPLMPluginID from = XPLM_NO_PLUGIN_ID);
+
+    // Publish the preset's ICAO and commands, hide every other preset's commands and
+    // send XPLM_MSG_PLANE_LOADED for the user aircraft
+    void LoadAircraft(AircraftPreset preset);
+    void UnloadAircraft();
+    AircraftPreset CurrentAircraft() const { return m_aircraft; }
+
+    // Run the plugin's toggle command for a side (1 = Captain, 2 = FO)
+    void ToggleInput(int side);
+
+    // Deliver one key event; returns 1 if the plugin passed it on, 0 if it consumed it
+    int SendKey(unsigned char virtual_key, XPLMKeyFlags flags, char character = 0);
+    // Key down followed by key up; returns the key-down result
+    int PressKey(unsigned char virtual_key, XPLMKeyFlags flags = 0, char character = 0);
+    // Press the key for every character in text (Shift+= for '+'); returns keys consumed
+    int TypeText(const char* text);
+
+    void RunFrames(int count, float seconds_per_frame = 1.0f / 60.0f);
+    // Run frames until the plugin stops firing commands and has finished looking up (and,
+    // if cached, verifying) the aircraft's commands, at most max_frames
+    int RunUntilIdle(int max_frames = 10000, float seconds_per_frame = 1.0f / 60.0f);
+
+private:
+    typedef int (*StartFunc)(char*, char*, char*);
+    typedef void (*VoidFunc)(void);
+    typedef int (*EnableFunc)(void);
+    typedef void (*ReceiveMessageFunc)(XPLMPluginID, int, void*);
+
+    void* m_handle;
+    StartFunc m_start;
+    VoidFunc m_stop;
+    EnableFunc m_enable;
+    VoidFunc m_disable;
+    ReceiveMessageFunc m_receive_message;
+    AircraftPreset m_aircraft;
+};
+
+// Delete the command availability cache the plugin keeps next to its binary, so a run does
+// not depend on earlier ones. Call before Load; returns false if there was none.
+bool RemoveCommandCache(const char* plugin_path);
+
+// Virtual key and flags that type a character; returns false if there is no such key
+bool CharacterToKey(char character, unsigned char* outVirtualKey, XPLMKeyFlags* outFlags);
+
+#endif // PLUGIN_HOST_H
@@ -0,0 +1,91 @@
+// fmc_host - drive the plugin headlessly on top of the XPLM stand-in
+//
+// Usage: fmc_host [--plugin lin.xpl] [--aircraft zibo|b738|a330|sr22|none] [--side 1|2]
+//                 [--type TEXT] [--frames N] [--log]
+//
+// Loads the plugin, loads the aircraft, toggles keyboard input for the side, types the
+// text as key presses, runs frames until the command queue is drained and prints the
+// commands the plugin fired (one per line, with the frame they were sent in).
+
+#include "PluginHost.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef FMC_KEYBOARD_PLUGIN_PATH
+#define FMC_KEYBOARD_PLUGIN_PATH "lin.xpl"
+#endif
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+            "Usage: fmc_host [--plugin lin.xpl] [--aircraft zibo|b738|a330|sr22|none] [--side 1|2]\n"
+            "                [--type TEXT] [--frames N] [--log]\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* plugin_path = FMC_KEYBOARD_PLUGIN_PATH;
+    AircraftPreset aircraft = AIRCRAFT_PRESET_ZIBO_737;
+    int side = 1;
+    const char* text = "";
+    int extra_frames = 0;
+    bool print_log = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (strcmp(arg, "--plugin") == 0 && has_value) {
+            plugin_path = argv[++i];
+        } else if (strcmp(arg, "--aircraft") == 0 && has_value) {
+            if (!ParseAircraftPreset(argv[++i], &aircraft)) {
+                fprintf(stderr, "Unknown aircraft '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--side") == 0 && has_value) {
+            side = atoi(argv[++i]);
+        } else if (strcmp(arg, "--type") == 0 && has_value) {
+            text = argv[++i];
+        } else if (strcmp(arg, "--frames") == 0 && has_value) {
+            extra_frames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--log") == 0) {
+            print_log = true;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    PluginHost host;
+    std::string error;
+    RemoveCommandCache(plugin_path);   // Start cold, whatever earlier runs left behind
+    if (!host.Load(plugin_path, &error)) {
+        fprintf(stderr, "Failed to load %s: %s\n", plugin_path, error.c_str());
+        return 1;
+    }
+
+    host.LoadAircraft(aircraft);
+    host.ToggleInput(side);
+    XPLMStub_ClearCommandEvents();
+
+    int consumed = host.TypeText(text);
+    int frames = host.RunUntilIdle();
+    host.RunFrames(extra_frames);
+
+    int count = XPLMStub_CountCommandEvents();
+    for (int i = 0; i < count; i++) {
+        XPLMStubCommandEvent event = XPLMStub_GetCommandEvent(i);
+        const char* phase = (event.phase == xplm_CommandBegin) ? "begin" : (event.phase == xplm_CommandEnd) ? "end" : "once";
+        printf("%6d %-5s %s\n", event.cycle, phase, event.name);
+    }
+    printf("# aircraft=%s side=%d keys_consumed=%d commands=%d frames=%d find_command=%lld get_datab=%lld\n",
+           AircraftPresetName(aircraft), side, consumed, count, frames + extra_frames,
+           XPLMStub_GetCounter(XPLMSTUB_FIND_COMMAND), XPLMStub_GetCounter(XPLMSTUB_GET_DATAB));
+
+    host.Unload();
+    if (print_log) {
+        fputs(XPLMStub_GetDebugLog(), stdout);
+    }
+    return 0;
+}
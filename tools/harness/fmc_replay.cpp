@@ -0,0 +1,204 @@
+// fmc_replay - feed a recorded keystroke session back through the plugin
+//
+// Usage: fmc_replay [--plugin lin.xpl] [--speed original|max] [--keys] [--commands] SESSION.bin
+//
+// Reads a recording made with Universal/FMC_Keyboard/Toggle_Recording (SessionRecording.h),
+// loads the plugin on the XPLM stand-in and replays every key event with the aircraft and
+// FMC side it was recorded with. Simulated frames (60 per second) are advanced from the
+// recorded timestamps, so the command stream is identical at either speed; --speed original
+// also sleeps to reproduce the real typing rhythm. Reports the dispatch cost of every key,
+// events whose outcome differs from the recording, and optionally the commands fired.
+
+#include "PluginHost.h"
+#include "SessionRecording.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#ifndef FMC_KEYBOARD_PLUGIN_PATH
+#define FMC_KEYBOARD_PLUGIN_PATH "lin.xpl"
+#endif
+
+static const double FRAMES_PER_SECOND = 60.0;
+
+static void PrintUsage()
+{
+    fprintf(stderr, "Usage: fmc_replay [--plugin lin.xpl] [--speed original|max] [--keys] [--commands] SESSION.bin\n");
+}
+
+static bool LoadSession(const char* path, std::vector<FMCSessionRecord>* records, std::string* error)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        *error = "cannot open file";
+        return false;
+    }
+
+    FMCSessionHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, FMC_SESSION_MAGIC, sizeof(FMC_SESSION_MAGIC)) != 0) {
+        *error = "not a session recording";
+        fclose(file);
+        return false;
+    }
+    if (header.version != FMC_SESSION_VERSION || header.record_size != sizeof(FMCSessionRecord)) {
+        *error = "unsupported recording version";
+        fclose(file);
+        return false;
+    }
+
+    FMCSessionRecord record;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        records->push_back(record);
+    }
+    fclose(file);
+    return true;
+}
+
+static AircraftPreset PresetForSessionAircraft(uint8_t aircraft)
+{
+    switch (aircraft) {
+        case FMC_SESSION_AIRCRAFT_ZIBO_737: return AIRCRAFT_PRESET_ZIBO_737;
+        case FMC_SESSION_AIRCRAFT_DEFAULT_737: return AIRCRAFT_PRESET_DEFAULT_737;
+        case FMC_SESSION_AIRCRAFT_DEFAULT_A330: return AIRCRAFT_PRESET_DEFAULT_A330;
+        case FMC_SESSION_AIRCRAFT_DEFAULT_SR22: return AIRCRAFT_PRESET_DEFAULT_SR22;
+        default: return AIRCRAFT_PRESET_NONE;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* plugin_path = FMC_KEYBOARD_PLUGIN_PATH;
+    const char* session_path = nullptr;
+    bool original_speed = false;
+    bool print_keys = false;
+    bool print_commands = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (strcmp(arg, "--plugin") == 0 && has_value) {
+            plugin_path = argv[++i];
+        } else if (strcmp(arg, "--speed") == 0 && has_value) {
+            const char* speed = argv[++i];
+            if (strcmp(speed, "original") == 0) {
+                original_speed = true;
+            } else if (strcmp(speed, "max") == 0) {
+                original_speed = false;
+            } else {
+                PrintUsage();
+                return 2;
+            }
+        } else if (strcmp(arg, "--keys") == 0) {
+            print_keys = true;
+        } else if (strcmp(arg, "--commands") == 0) {
+            print_commands = true;
+        } else if (arg[0] != '-' && session_path == nullptr) {
+            session_path = arg;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (session_path == nullptr) {
+        PrintUsage();
+        return 2;
+    }
+
+    std::vector<FMCSessionRecord> records;
+    std::string error;
+    if (!LoadSession(session_path, &records, &error)) {
+        fprintf(stderr, "Failed to read %s: %s\n", session_path, error.c_str());
+        return 1;
+    }
+
+    PluginHost host;
+    RemoveCommandCache(plugin_path);   // Start cold, whatever earlier runs left behind
+    if (!host.Load(plugin_path, &error)) {
+        fprintf(stderr, "Failed to load %s: %s\n", plugin_path, error.c_str());
+        return 1;
+    }
+    XPLMStub_ClearCommandEvents();
+
+    std::vector<long long> costs;
+    costs.reserve(records.size());
+    int mismatches = 0;
+    int toggled_side = 0;           // Side input is toggled on for, 0 = off
+    long long frames = 0;
+    double frame_debt = 0.0;        // Recorded time not yet covered by simulated frames
+    int64_t previous_time_ns = records.empty() ? 0 : records[0].time_ns;
+    std::chrono::steady_clock::time_point replay_start = std::chrono::steady_clock::now();
+
+    if (print_keys) {
+        printf("# index time_ms vk flags button recorded replayed ns\n");
+    }
+    for (size_t i = 0; i < records.size(); i++) {
+        const FMCSessionRecord& record = records[i];
+
+        // Let queued commands drain for the time that passed between the two events
+        frame_debt += (record.time_ns - previous_time_ns) * 1e-9 * FRAMES_PER_SECOND;
+        previous_time_ns = record.time_ns;
+        int due_frames = (int)frame_debt;
+        if (due_frames > 0) {
+            frames += host.RunUntilIdle(due_frames);
+            frame_debt -= due_frames;
+        }
+
+        // Reproduce the aircraft and side the event was recorded with
+        AircraftPreset preset = PresetForSessionAircraft(record.aircraft);
+        if (preset != host.CurrentAircraft()) {
+            frames += host.RunUntilIdle();   // An aircraft load takes seconds; the queue has drained by then
+            if (toggled_side != 0) host.ToggleInput(toggled_side);   // Re-enable below for the new aircraft
+            toggled_side = 0;
+            host.LoadAircraft(preset);
+        }
+        if (toggled_side != record.side) {
+            if (toggled_side != 0) host.ToggleInput(toggled_side);
+            host.ToggleInput(record.side);
+            toggled_side = record.side;
+        }
+
+        if (original_speed) {
+            std::this_thread::sleep_until(replay_start + std::chrono::nanoseconds(record.time_ns));
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int result = host.SendKey(record.virtual_key, record.flags, (char)record.character);
+        long long cost = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        costs.push_back(cost);
+
+        int consumed = (result == 0) ? 1 : 0;
+        bool mismatch = (consumed != record.consumed);
+        if (mismatch) mismatches++;
+        if (print_keys || mismatch) {
+            printf("%6zu %10.3f %3u 0x%02x %3u %8s %8s %6lld%s\n", i, record.time_ns / 1e6, record.virtual_key,
+                   record.flags, record.button, record.consumed ? "consumed" : "passed", consumed ? "consumed" : "passed",
+                   cost, mismatch ? "  MISMATCH" : "");
+        }
+    }
+    frames += host.RunUntilIdle();
+
+    int command_count = XPLMStub_CountCommandEvents();
+    if (print_commands) {
+        for (int i = 0; i < command_count; i++) {
+            XPLMStubCommandEvent event = XPLMStub_GetCommandEvent(i);
+            const char* phase = (event.phase == xplm_CommandBegin) ? "begin" : (event.phase == xplm_CommandEnd) ? "end" : "once";
+            printf("%6d %-5s %s\n", event.cycle, phase, event.name);
+        }
+    }
+
+    std::vector<long long> sorted = costs;
+    std::sort(sorted.begin(), sorted.end());
+    long long p50 = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    long long p99 = sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+    long long max = sorted.empty() ? 0 : sorted.back();
+    printf("# keys=%zu mismatches=%d commands=%d frames=%lld dispatch_ns_p50=%lld p99=%lld max=%lld\n",
+           records.size(), mismatches, command_count, frames, p50, p99, max);
+
+    host.Unload();
+    return (mismatches == 0) ? 0 : 1;
+}
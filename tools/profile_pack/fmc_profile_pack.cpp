@@ -0,0 +1,159 @@
+// fmc_profile_pack - compile aircraft profile files into a binary profile pack
+//
+// Usage: fmc_profile_pack [--output FILE] [--list] PROFILE_DIR
+//
+// Parses every *.profile file in PROFILE_DIR together with the plugin's built-in aircraft,
+// exactly as the plugin does at startup, and writes the result as a profile pack
+// (src/ProfilePack.h), by default PROFILE_DIR/profiles.pack. The plugin maps the pack
+// instead of parsing text, as long as the profile files and the plugin build it was
+// compiled for are unchanged. Any invalid profile is an error here rather than a warning.
+
+#include "AircraftProfile.h"
+#include "ProfilePack.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static void PrintUsage()
+{
+    fprintf(stderr, "Usage: fmc_profile_pack [--output FILE] [--list] PROFILE_DIR\n");
+}
+
+static bool ReadFile(const std::string& path, std::vector<char>* contents)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+    char buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents->insert(contents->end(), buffer, buffer + count);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+static bool WriteFile(const std::string& path, const std::vector<uint8_t>& contents)
+{
+    // Write next to the target and rename, so the plugin never maps a half-written pack
+    std::string temp_path = path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (file == nullptr) return false;
+    bool ok = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    ok = (fclose(file) == 0) && ok;
+    if (ok) {
+        std::error_code error;
+        std::filesystem::rename(temp_path, path, error);
+        ok = !error;
+    }
+    if (!ok) remove(temp_path.c_str());
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    const char* output_path = nullptr;
+    const char* profile_dir = nullptr;
+    bool list = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(arg, "--list") == 0) {
+            list = true;
+        } else if (arg[0] != '-' && profile_dir == nullptr) {
+            profile_dir = arg;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (profile_dir == nullptr) {
+        PrintUsage();
+        return 2;
+    }
+    std::string output = output_path ? output_path : (std::filesystem::path(profile_dir) / FMC_PROFILE_PACK_FILE).string();
+
+    std::vector<std::string> files;
+    std::error_code error_code;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(profile_dir, error_code)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".profile") {
+            files.push_back(entry.path().filename().string());
+        }
+    }
+    if (error_code) {
+        fprintf(stderr, "Cannot read %s: %s\n", profile_dir, error_code.message().c_str());
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<AircraftProfile> profiles;
+    AppendBuiltinProfiles(&profiles);
+    size_t builtin_count = profiles.size();
+    uint64_t builtin_hash = HashAircraftProfiles(profiles);
+
+    std::vector<ProfileSourceStamp> sources;
+    int failures = 0;
+    for (const std::string& name : files) {
+        std::string path = (std::filesystem::path(profile_dir) / name).string();
+        ProfileSourceStamp stamp;
+        stamp.name = name;
+        std::vector<char> text;
+        if (!GetProfileSourceStamp(path.c_str(), &stamp.size, &stamp.modified) || !ReadFile(path, &text)) {
+            fprintf(stderr, "%s: cannot read file\n", path.c_str());
+            failures++;
+            continue;
+        }
+
+        AircraftProfile profile;
+        char error[256];
+        if (!ParseAircraftProfile(text.data(), text.size(), name.c_str(), &profile, error, sizeof(error))) {
+            fprintf(stderr, "%s\n", error);
+            failures++;
+            continue;
+        }
+        ProfileAddResult result = AddAircraftProfile(&profiles, builtin_count, profile);
+        if (result == PROFILE_DUPLICATE_NAME) {
+            fprintf(stderr, "%s: another profile is already named \"%s\"\n", name.c_str(), profile.name);
+            failures++;
+            continue;
+        }
+        if (result == PROFILE_REPLACED_BUILTIN) {
+            printf("%s replaces built-in \"%s\"\n", name.c_str(), profile.name);
+        }
+        sources.push_back(stamp);
+    }
+    if (failures > 0) {
+        fprintf(stderr, "%d profile file(s) failed, no pack written\n", failures);
+        return 1;
+    }
+    SortAircraftProfiles(&profiles, builtin_count);
+
+    std::vector<uint8_t> pack;
+    char error[256];
+    if (!BuildProfilePack(profiles, sources, builtin_hash, &pack, error, sizeof(error))) {
+        fprintf(stderr, "Cannot build pack: %s\n", error);
+        return 1;
+    }
+    if (!WriteFile(output, pack)) {
+        fprintf(stderr, "Cannot write %s\n", output.c_str());
+        return 1;
+    }
+
+    if (list) {
+        printf("# detection order: priority name icao/acf_file\n");
+        for (const AircraftProfile& profile : profiles) {
+            printf("%5d %-24s", profile.priority, profile.name);
+            for (int i = 0; i < profile.icao_count; i++) printf(" %s", profile.icao[i]);
+            for (int i = 0; i < profile.acf_file_count; i++) printf(" %s", profile.acf_files[i]);
+            printf("\n");
+        }
+    }
+    printf("Wrote %s: %zu profiles (%zu profile files), %zu bytes\n", output.c_str(), profiles.size(), sources.size(), pack.size());
+    return 0;
+}
@@ -0,0 +1,743 @@
+// fmc_scenario_tests - behaviour checks for the plugin on the XPLM stand-in
+//
+// Usage: fmc_scenario_tests [--plugin lin.xpl]
+//
+// Each scenario loads the plugin with no command cache, plays aircraft loads and key
+// presses through PluginHost and compares the commands the plugin fired (and the datarefs
+// and log it wrote) with the expected ones. Prints one PASS/FAIL line per scenario; the exit code is 1 if any failed.
+// Registered with ctest when the harness is built.
+
+#include "PluginHost.h"
+
+#include "FMCKeyboardAPI.h"
+#include "XPLMDataAccess.h"
+#include "XPLMPlanes.h"
+#include "XPLMPlugin.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef FMC_KEYBOARD_PLUGIN_PATH
+#define FMC_KEYBOARD_PLUGIN_PATH "lin.xpl"
+#endif
+
+static const char* g_plugin_path = FMC_KEYBOARD_PLUGIN_PATH;
+
+// Names of the commands fired since the last call (XPLMCommandOnce only)
+static std::vector<std::string> TakeCommands()
+{
+    std::vector<std::string> names;
+    for (int i = 0; i < XPLMStub_CountCommandEvents(); i++) {
+        XPLMStubCommandEvent event = XPLMStub_GetCommandEvent(i);
+        if (event.phase == -1) names.push_back(event.name);
+    }
+    XPLMStub_ClearCommandEvents();
+    return names;
+}
+
+static std::string Join(const std::vector<std::string>& names)
+{
+    std::string text;
+    for (const std::string& name : names) {
+        if (!text.empty()) text += ", ";
+        text += name;
+    }
+    return text.empty() ? "(none)" : text;
+}
+
+// Compare fired commands; prints what differed and returns false on a mismatch
+static bool ExpectCommands(const char* step, const std::vector<std::string>& expected)
+{
+    std::vector<std::string> fired = TakeCommands();
+    if (fired == expected) return true;
+    printf("  %s: expected %s\n  %s: fired    %s\n", step, Join(expected).c_str(), step, Join(fired).c_str());
+    return false;
+}
+
+// Every command event since the last call: "name" for XPLMCommandOnce, "+name" for a begin,
+// "-name" for an end
+static bool ExpectCommandEvents(const char* step, const std::vector<std::string>& expected)
+{
+    std::vector<std::string> events;
+    for (int i = 0; i < XPLMStub_CountCommandEvents(); i++) {
+        XPLMStubCommandEvent event = XPLMStub_GetCommandEvent(i);
+        const char* prefix = (event.phase == xplm_CommandBegin) ? "+" : (event.phase == xplm_CommandEnd) ? "-" : "";
+        events.push_back(prefix + std::string(event.name));
+    }
+    XPLMStub_ClearCommandEvents();
+    if (events == expected) return true;
+    printf("  %s: expected %s\n  %s: fired    %s\n", step, Join(expected).c_str(), step, Join(events).c_str());
+    return false;
+}
+
+// Number of commands fired in each frame that fired any, in order (events are kept)
+static std::vector<int> CountCommandsPerFrame()
+{
+    std::vector<int> counts;
+    int last_cycle = -1;
+    for (int i = 0; i < XPLMStub_CountCommandEvents(); i++) {
+        XPLMStubCommandEvent event = XPLMStub_GetCommandEvent(i);
+        if (event.cycle != last_cycle) counts.push_back(0);
+        counts.back()++;
+        last_cycle = event.cycle;
+    }
+    return counts;
+}
+
+// Compare how the fired commands were spread over frames
+static bool ExpectCommandsPerFrame(const char* step, const std::vector<int>& expected)
+{
+    std::vector<int> counts = CountCommandsPerFrame();
+    if (counts == expected) return true;
+    std::string text;
+    for (int count : counts) text += (text.empty() ? "" : ", ") + std::to_string(count);
+    printf("  %s: commands per frame %s\n", step, text.empty() ? "(none)" : text.c_str());
+    return false;
+}
+
+// Set an int dataref the plugin publishes
+static void SetPluginDataRef(const char* name, int value)
+{
+    XPLMSetDatai(XPLMFindDataRef(name), value);
+}
+
+// Send text through the inter-plugin API (FMCKeyboardAPI.h); returns the filled-in message
+static FMCKeyboardTextMessage InjectText(PluginHost& host, int side, const char* text)
+{
+    FMCKeyboardTextMessage message;
+    memset(&message, 0, sizeof(message));
+    message.structSize = sizeof(message);
+    message.side = side;
+    message.text = text;
+    message.length = -1;
+    host.SendMessage(FMC_KEYBOARD_MSG_TYPE_TEXT, &message);
+    return message;
+}
+
+// Compare the number of visible plugin windows (the status window is the only one)
+static bool ExpectVisibleWindows(const char* step, int expected)
+{
+    int visible = XPLMStub_CountVisibleWindows();
+    if (visible == expected) return true;
+    printf("  %s: expected %d visible windows, found %d\n", step, expected, visible);
+    return false;
+}
+
+// Check that the plugin's log (everything passed to XPLMDebugString) contains text
+static bool ExpectLogged(const char* step, const char* text)
+{
+    if (strstr(XPLMStub_GetDebugLog(), text) != nullptr) return true;
+    printf("  %s: \"%s\" not logged\n", step, text);
+    return false;
+}
+
+// Path of a file in the profiles/ folder next to the plugin (created if needed)
+static std::string ProfilePath(const char* file_name)
+{
+    std::string folder = g_plugin_path;
+    size_t separator = folder.rfind('/');
+    folder = (separator == std::string::npos) ? std::string("profiles") : folder.substr(0, separator + 1) + "profiles";
+    mkdir(folder.c_str(), 0755);
+    return folder + "/" + file_name;
+}
+
+// Install a profile file for the next plugin load
+static void WriteProfile(const char* file_name, const char* text)
+{
+    FILE* file = fopen(ProfilePath(file_name).c_str(), "w");
+    if (file == nullptr) return;
+    fputs(text, file);
+    fclose(file);
+}
+
+static void RemoveProfile(const char* file_name)
+{
+    remove(ProfilePath(file_name).c_str());
+}
+
+// Type text and run frames until the plugin is idle
+static void Type(PluginHost& host, const char* text)
+{
+    XPLMStub_ClearCommandEvents();
+    host.TypeText(text);
+    host.RunUntilIdle();
+}
+
+// Load the plugin on a freshly reset stand-in; with cold set, without a command cache
+static bool StartSession(PluginHost& host, bool cold)
+{
+    XPLMStub_Reset();
+    if (cold) RemoveCommandCache(g_plugin_path);
+    std::string error;
+    if (!host.Load(g_plugin_path, &error)) {
+        printf("  cannot load %s: %s\n", g_plugin_path, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Hide or show a command the aircraft provides
+static void HideCommand(const char* name, bool hidden)
+{
+    XPLMStub_SetCommandHidden(name, hidden ? 1 : 0);
+}
+
+// Every supported aircraft routes keys to its own FMC commands
+static bool DetectionScenario()
+{
+    struct Case {
+        AircraftPreset aircraft;
+        const char* first;
+        const char* second;
+    };
+    const Case cases[] = {
+        {AIRCRAFT_PRESET_ZIBO_737, "laminar/B738/button/fmc1_A", "laminar/B738/button/fmc1_1"},
+        {AIRCRAFT_PRESET_DEFAULT_737, "sim/FMS/key_a", "sim/FMS/key_1"},
+        {AIRCRAFT_PRESET_DEFAULT_A330, "sim/FMS/key_a", "sim/FMS/key_1"},
+        {AIRCRAFT_PRESET_DEFAULT_SR22, "sim/GPS/gcu478/A", "sim/GPS/gcu478/1"},
+    };
+    bool ok = true;
+    for (const Case& c : cases) {
+        PluginHost host;
+        if (!StartSession(host, true)) return false;
+        host.LoadAircraft(c.aircraft);
+        host.RunUntilIdle();
+        host.ToggleInput(1);
+        Type(host, "A1");
+        ok = ExpectCommands(AircraftPresetName(c.aircraft), {c.first, c.second}) && ok;
+        host.Unload();
+    }
+    return ok;
+}
+
+// Switching aircraft with input on: FO side carries over between dual-FMC aircraft, and a
+// single-FMC aircraft uses its only FMC even if input was turned on for the FO
+static bool AircraftSwitchScenario()
+{
+    PluginHost host;
+    if (!StartSession(host, true)) return false;
+    bool ok = true;
+
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    host.RunUntilIdle();
+    host.ToggleInput(2);
+    Type(host, "A");
+    ok = ExpectCommands("zibo FO", {"laminar/B738/button/fmc2_A"}) && ok;
+
+    host.LoadAircraft(AIRCRAFT_PRESET_DEFAULT_737);
+    Type(host, "A");
+    ok = ExpectCommands("b738 FO", {"sim/FMS2/key_a"}) && ok;
+
+    host.LoadAircraft(AIRCRAFT_PRESET_DEFAULT_SR22);
+    Type(host, "A");
+    ok = ExpectCommands("sr22 after FO", {"sim/GPS/gcu478/A"}) && ok;
+
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    Type(host, "A");
+    ok = ExpectCommands("zibo again", {"laminar/B738/button/fmc1_A"}) && ok;
+
+    // The status window is hidden while no aircraft is loaded and shown again after
+    host.UnloadAircraft();
+    ok = ExpectVisibleWindows("unloaded", 0) && ok;
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    ok = ExpectVisibleWindows("reloaded", 1) && ok;
+    Type(host, "A");
+    ok = ExpectCommands("reloaded", {"laminar/B738/button/fmc1_A"}) && ok;
+
+    host.Unload();
+    return ok;
+}
+
+// An aircraft plugin that creates its commands after the plane loaded: the toggle's
+// re-detection must switch to the right profile, also on later toggles
+static bool LateCommandsScenario()
+{
+    PluginHost host;
+    if (!StartSession(host, true)) return false;
+    bool ok = true;
+
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    HideCommand("laminar/B738/button/fmc1_0", true);
+    HideCommand("laminar/B738/button/fmc1_A", true);
+    host.SendMessage(XPLM_MSG_PLANE_LOADED, (void*)(intptr_t)XPLM_USER_AIRCRAFT);
+    host.RunFrames(10);   // Detected as the default 737; its table is resolved and kept
+    HideCommand("laminar/B738/button/fmc1_0", false);
+    HideCommand("laminar/B738/button/fmc1_A", false);
+
+    for (int toggle = 0; toggle < 2; toggle++) {
+        host.ToggleInput(1);
+        Type(host, "A");
+        ok = ExpectCommands(toggle == 0 ? "first toggle" : "second toggle", {"laminar/B738/button/fmc1_A"}) && ok;
+        host.ToggleInput(1);
+    }
+
+    host.Unload();
+    return ok;
+}
+
+// A command missing when the cache was written is looked up again in a later session
+static bool CacheMissingCommandScenario()
+{
+    bool ok = true;
+    {
+        PluginHost host;
+        if (!StartSession(host, true)) return false;
+        host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+        HideCommand("laminar/B738/button/fmc1_A", true);
+        host.RunUntilIdle();
+        host.Unload();   // Writes the cache with fmc1_A missing
+    }
+
+    PluginHost host;
+    if (!StartSession(host, false)) return false;
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    host.RunUntilIdle();
+    host.ToggleInput(1);
+    XPLMStub_ResetCounters();
+    Type(host, "A");
+    ok = ExpectCommands("warm start", {"laminar/B738/button/fmc1_A"}) && ok;
+    if (XPLMStub_GetCounter(XPLMSTUB_FIND_COMMAND) != 0) {
+        printf("  warm start: key needed %lld XPLMFindCommand calls, expected the background job to have found it\n",
+               XPLMStub_GetCounter(XPLMSTUB_FIND_COMMAND));
+        ok = false;
+    }
+    host.Unload();
+    RemoveCommandCache(g_plugin_path);
+    return ok;
+}
+
+// Keys typed before the background check overturns a cached detection are sent with the
+// newly detected aircraft's commands
+static bool CacheOverturnedScenario()
+{
+    {
+        PluginHost host;
+        if (!StartSession(host, true)) return false;
+        host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+        host.RunUntilIdle();
+        host.Unload();   // Caches the ZIBO profile for this aircraft
+    }
+
+    // Same aircraft files, but now only the default FMS commands exist
+    PluginHost host;
+    if (!StartSession(host, false)) return false;
+    host.LoadAircraft(AIRCRAFT_PRESET_DEFAULT_737);
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    HideCommand("laminar/B738/button/fmc1_0", true);
+    const char* const default_keys[] = {"a", "b", "1", "minus"};
+    for (const char* key : default_keys) {
+        std::string name = std::string("sim/FMS/key_") + key;
+        HideCommand(name.c_str(), false);
+    }
+    host.ToggleInput(1);
+    XPLMStub_ClearCommandEvents();
+    host.TypeText("AB1-");
+    host.RunUntilIdle();
+    bool ok = ExpectCommands("overturned", {"sim/FMS/key_a", "sim/FMS/key_b", "sim/FMS/key_1", "sim/FMS/key_minus"});
+    host.Unload();
+    RemoveCommandCache(g_plugin_path);
+    return ok;
+}
+
+// Keystrokes go out at commands_per_frame per side per frame, and text still queued when
+// input is turned on (which re-detects the aircraft) is sent, not dropped
+static bool PacingScenario()
+{
+    PluginHost host;
+    if (!StartSession(host, true)) return false;
+    bool ok = true;
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    host.RunUntilIdle();
+
+    XPLMStub_ClearCommandEvents();
+    InjectText(host, FMC_KEYBOARD_SIDE_CAPTAIN, "ABCD");
+    host.ToggleInput(1);
+    host.RunUntilIdle();
+    ok = ExpectCommandsPerFrame("one per frame", {1, 1, 1, 1}) && ok;
+    ok = ExpectCommands("queued before toggle", {"laminar/B738/button/fmc1_A", "laminar/B738/button/fmc1_B",
+                                                 "laminar/B738/button/fmc1_C", "laminar/B738/button/fmc1_D"}) && ok;
+
+    SetPluginDataRef("Universal/FMC_Keyboard/queue/commands_per_frame", 2);
+    XPLMStub_ClearCommandEvents();
+    host.TypeText("12345");
+    host.RunUntilIdle();
+    ok = ExpectCommandsPerFrame("two per frame", {2, 2, 1}) && ok;
+    ok = ExpectCommands("typed", {"laminar/B738/button/fmc1_1", "laminar/B738/button/fmc1_2", "laminar/B738/button/fmc1_3",
+                                  "laminar/B738/button/fmc1_4", "laminar/B738/button/fmc1_5"}) && ok;
+
+    host.Unload();
+    return ok;
+}
+
+// Text sent through the inter-plugin API goes to the requested FMC with the aircraft's key
+// commands; characters without a key are counted as rejected (non-ASCII ones once each)
+static bool TextInjectionScenario()
+{
+    PluginHost host;
+    if (!StartSession(host, true)) return false;
+    bool ok = true;
+
+    struct Case {
+        AircraftPreset aircraft;
+        int side;
+        const char* text;
+        int accepted;
+        int rejected;
+        std::vector<std::string> commands;
+    };
+    const Case cases[] = {
+        {AIRCRAFT_PRESET_ZIBO_737, FMC_KEYBOARD_SIDE_FO, "ks/1 .\n", 7, 0,
+         {"laminar/B738/button/fmc2_K", "laminar/B738/button/fmc2_S", "laminar/B738/button/fmc2_slash",
+          "laminar/B738/button/fmc2_1", "laminar/B738/button/fmc2_SP", "laminar/B738/button/fmc2_period",
+          "laminar/B738/button/fmc2_ent"}},
+        {AIRCRAFT_PRESET_DEFAULT_737, FMC_KEYBOARD_SIDE_CAPTAIN, "A\xC3\x89" "B", 2, 1, {"sim/FMS/key_a", "sim/FMS/key_b"}},
+        {AIRCRAFT_PRESET_DEFAULT_SR22, FMC_KEYBOARD_SIDE_FO, "A/B", 2, 1, {"sim/GPS/gcu478/A", "sim/GPS/gcu478/B"}},
+        {AIRCRAFT_PRESET_NONE, FMC_KEYBOARD_SIDE_CAPTAIN, "AB", 0, 2, {}},
+    };
+    for (const Case& c : cases) {
+        host.LoadAircraft(c.aircraft);
+        host.RunUntilIdle();
+        XPLMStub_ClearCommandEvents();
+        FMCKeyboardTextMessage message = InjectText(host, c.side, c.text);
+        host.RunUntilIdle();
+        if (message.outAccepted != c.accepted || message.outRejected != c.rejected) {
+            printf("  %s: accepted %d, rejected %d; expected %d, %d\n", AircraftPresetName(c.aircraft),
+                   message.outAccepted, message.outRejected, c.accepted, c.rejected);
+            ok = false;
+        }
+        ok = ExpectCommands(AircraftPresetName(c.aircraft), c.commands) && ok;
+    }
+
+    host.Unload();
+    return ok;
+}
+
+// With queue/hold_keys set, a key presses its FMC button on key down and releases it on key
+// up; toggling input off releases anything still held
+static bool HoldModeScenario()
+{
+    PluginHost host;
+    if (!StartSession(host, true)) return false;
+    bool ok = true;
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    host.RunUntilIdle();
+    host.ToggleInput(1);
+    SetPluginDataRef("Universal/FMC_Keyboard/queue/hold_keys", 1);
+    XPLMStub_ClearCommandEvents();
+
+    // Nothing is queued for a release, so each is given a frame to be sent
+    host.SendKey(XPLM_VK_BACK, xplm_DownFlag);
+    host.RunFrames(5);
+    ok = ExpectCommandEvents("held", {"+laminar/B738/button/fmc1_clr"}) && ok;
+    host.SendKey(XPLM_VK_BACK, xplm_UpFlag);
+    host.RunFrames(1);
+    ok = ExpectCommandEvents("released", {"-laminar/B738/button/fmc1_clr"}) && ok;
+
+    // Released before the begin was sent: still a complete press
+    host.TypeText("A");
+    host.RunUntilIdle();
+    ok = ExpectCommandEvents("tapped", {"+laminar/B738/button/fmc1_A", "-laminar/B738/button/fmc1_A"}) && ok;
+
+    host.SendKey(XPLM_VK_B, xplm_DownFlag);
+    host.RunFrames(2);
+    host.ToggleInput(1);
+    host.RunFrames(1);
+    ok = ExpectCommandEvents("toggled off", {"+laminar/B738/button/fmc1_B", "-laminar/B738/button/fmc1_B"}) && ok;
+
+    host.ToggleInput(1);
+    SetPluginDataRef("Universal/FMC_Keyboard/queue/hold_keys", 0);
+    Type(host, "C");
+    ok = ExpectCommandEvents("hold off", {"laminar/B738/button/fmc1_C"}) && ok;
+
+    host.Unload();
+    return ok;
+}
+
+// Hold a key for a few OS auto-repeats, then release it, running a frame after each event
+static void HoldKey(PluginHost& host, unsigned char virtual_key, int repeats)
+{
+    for (int i = 0; i <= repeats; i++) {
+        host.SendKey(virtual_key, xplm_DownFlag);
+        host.RunFrames(1);
+    }
+    host.SendKey(virtual_key, xplm_UpFlag);
+    host.RunFrames(1);
+    host.RunUntilIdle();
+}
+
+// Auto-repeats follow the aircraft's repeat policy: letters ignore them, a held CLR holds
+// the button on the ZIBO and clears once per repeat on the other aircraft. A key whose key
+// up never arrived is not stuck in auto-repeat.
+static bool RepeatPolicyScenario()
+{
+    PluginHost host;
+    if (!StartSession(host, true)) return false;
+    bool ok = true;
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    host.RunUntilIdle();
+    host.ToggleInput(1);
+    XPLMStub_ClearCommandEvents();
+
+    HoldKey(host, XPLM_VK_A, 3);
+    ok = ExpectCommandEvents("zibo letter", {"laminar/B738/button/fmc1_A"}) && ok;
+    HoldKey(host, XPLM_VK_BACK, 3);
+    ok = ExpectCommandEvents("zibo CLR", {"laminar/B738/button/fmc1_clr", "+laminar/B738/button/fmc1_clr",
+                                          "-laminar/B738/button/fmc1_clr"}) && ok;
+
+    // The key up is lost; a press after longer than any OS repeat delay is a new press
+    host.SendKey(XPLM_VK_B, xplm_DownFlag);
+    host.RunUntilIdle();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    host.SendKey(XPLM_VK_B, xplm_DownFlag);
+    host.SendKey(XPLM_VK_B, xplm_UpFlag);
+    host.RunUntilIdle();
+    ok = ExpectCommandEvents("lost key up", {"laminar/B738/button/fmc1_B", "laminar/B738/button/fmc1_B"}) && ok;
+
+    host.LoadAircraft(AIRCRAFT_PRESET_DEFAULT_737);
+    host.RunUntilIdle();
+    XPLMStub_ClearCommandEvents();
+    HoldKey(host, XPLM_VK_BACK, 2);
+    ok = ExpectCommandEvents("b738 CLR", {"sim/FMS/key_clear", "sim/FMS/key_clear", "sim/FMS/key_clear"}) && ok;
+
+    host.LoadAircraft(AIRCRAFT_PRESET_DEFAULT_SR22);
+    host.RunUntilIdle();
+    XPLMStub_ClearCommandEvents();
+    HoldKey(host, XPLM_VK_BACK, 2);
+    ok = ExpectCommandEvents("sr22 CLR", {"sim/GPS/gcu478/clr", "sim/GPS/gcu478/clr", "sim/GPS/gcu478/clr"}) && ok;
+
+    host.Unload();
+    return ok;
+}
+
+// Set the text of a scratchpad dataref (size bytes, the rest filled with pad)
+static void SetScratchpad(const char* dataref, const char* text, int size, char pad, bool writable)
+{
+    std::string bytes(size, pad);
+    bytes.replace(0, strlen(text), text);
+    XPLMStub_SetDatab(dataref, bytes.data(), size, writable ? 1 : 0);
+}
+
+// +/- presses the aircraft's minus key only as often as needed for the sign at the end of
+// the scratchpad: read from the scratchpad dataref, or predicted from the keys typed
+static bool SignTrackingScenario()
+{
+    PluginHost host;
+    if (!StartSession(host, true)) return false;
+    bool ok = true;
+    const char* scratchpad = "laminar/B738/fmc1/Line_entry";
+    const std::string minus = "laminar/B738/button/fmc1_minus";
+    SetScratchpad(scratchpad, "", 24, '\0', false);
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    host.RunUntilIdle();
+    host.ToggleInput(1);
+
+    struct Case {
+        const char* scratchpad;
+        const char* typed;
+        int presses;
+    };
+    const Case cases[] = {
+        {"", "-", 1},          // Append "-"
+        {"", "+", 2},          // Append "-", flip to "+"
+        {"12-", "+", 1},       // Flip
+        {"12+", "-", 1},       // Flip
+        {"12+", "+", 0},       // Already there
+        {"", "1-+", 2},        // Predicted while the keys are queued: append, then flip
+    };
+    for (const Case& c : cases) {
+        SetScratchpad(scratchpad, c.scratchpad, 24, '\0', false);
+        host.RunFrames(5);     // Past the frames the dataref may lag behind
+        Type(host, c.typed);
+        int presses = 0;
+        for (const std::string& name : TakeCommands()) {
+            if (name == minus) presses++;
+        }
+        if (presses != c.presses) {
+            printf("  \"%s\" + \"%s\": %d minus presses, expected %d\n", c.scratchpad, c.typed, presses, c.presses);
+            ok = false;
+        }
+    }
+
+    host.Unload();
+    return ok;
+}
+
+// Compare the bytes of a scratchpad dataref with text padded to its size
+static bool ExpectScratchpad(const char* step, const char* dataref, const char* text, int size, char pad)
+{
+    std::string expected(size, pad);
+    expected.replace(0, strlen(text), text);
+    std::string found(size, '\0');
+    found.resize(XPLMGetDatab(XPLMFindDataRef(dataref), &found[0], 0, size));
+    if (found == expected) return true;
+    for (char& c : found) {
+        if (c == '\0') c = '.';
+    }
+    printf("  %s: scratchpad \"%s\", expected \"%s\" (NUL shown as .)\n", step, found.c_str(), text);
+    return false;
+}
+
+// ZIBO 737 replaced by a profile that types text by writing the scratchpad dataref
+static const char* const SCRATCHPAD_WRITE_PROFILE =
+    "name = ZIBO 737\n"
+    "label = 737\n"
+    "icao = B738\n"
+    "require_command = laminar/B738/button/fmc1_0\n"
+    "priority = 10\n"
+    "dual_fmc = yes\n"
+    "command_format = laminar/B738/button/fmc%d_%s\n"
+    "key.CLR = clr\n"
+    "key.SP = SP\n"
+    "key.DEL = del\n"
+    "key.ENT = ent\n"
+    "key.SLASH = slash\n"
+    "key.PERIOD = period\n"
+    "plus_minus = toggle\n"
+    "minus_command = laminar/B738/button/fmc%d_minus\n"
+    "scratchpad_dataref = laminar/B738/fmc%d/Line_entry\n"
+    "scratchpad_write = yes\n";
+
+// Characters are appended to the scratchpad dataref after its text and padding, and typed
+// with commands when they do not fit or the dataref does not take them
+static bool ScratchpadWriteScenario()
+{
+    const char* scratchpad = "laminar/B738/fmc1/Line_entry";
+    WriteProfile("scratchpad_write.profile", SCRATCHPAD_WRITE_PROFILE);
+    PluginHost host;
+    bool ok = StartSession(host, true);
+    if (!ok) {
+        RemoveProfile("scratchpad_write.profile");
+        return false;
+    }
+    SetScratchpad(scratchpad, "", 24, '\0', true);
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    host.RunUntilIdle();
+    host.ToggleInput(1);
+
+    // Size 0: nothing fits
+    SetScratchpad(scratchpad, "", 0, '\0', true);
+    Type(host, "AB");
+    ok = ExpectCommands("size 0", {"laminar/B738/button/fmc1_A", "laminar/B738/button/fmc1_B"}) && ok;
+
+    // Space padded: appended after the text, and a space typed last waits for what follows
+    SetScratchpad(scratchpad, "KSEA", 24, ' ', true);
+    Type(host, "12");
+    Type(host, " ");
+    ok = ExpectScratchpad("space padded", scratchpad, "KSEA12", 24, ' ') && ok;
+    Type(host, "B");
+    ok = ExpectScratchpad("space padded", scratchpad, "KSEA12 B", 24, ' ') && ok;
+    ok = ExpectCommands("space padded", {}) && ok;
+
+    // NUL filled
+    SetScratchpad(scratchpad, "KSEA", 24, '\0', true);
+    Type(host, "12/3");
+    ok = ExpectScratchpad("NUL filled", scratchpad, "KSEA12/3", 24, '\0') && ok;
+    ok = ExpectCommands("NUL filled", {}) && ok;
+
+    // Too long for the dataref: typed with commands, still ahead of the ENT typed after it
+    SetScratchpad(scratchpad, "KSEA", 6, '\0', true);
+    Type(host, "123\n");
+    ok = ExpectScratchpad("too long", scratchpad, "KSEA", 6, '\0') && ok;
+    ok = ExpectCommands("too long", {"laminar/B738/button/fmc1_1", "laminar/B738/button/fmc1_2",
+                                     "laminar/B738/button/fmc1_3", "laminar/B738/button/fmc1_ent"}) && ok;
+    host.Unload();
+
+    // A profile scratchpad_size larger than the dataref: the write is cut short, so the
+    // text is typed with commands and the side stops writing the dataref
+    std::string profile = std::string(SCRATCHPAD_WRITE_PROFILE) + "scratchpad_size = 32\n";
+    WriteProfile("scratchpad_write.profile", profile.c_str());
+    if (ok) ok = StartSession(host, false);
+    RemoveProfile("scratchpad_write.profile");
+    if (!ok) return false;
+    SetScratchpad(scratchpad, "KSEA", 6, '\0', true);
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    host.RunUntilIdle();
+    host.ToggleInput(1);
+    Type(host, "123");
+    ok = ExpectCommands("failed write", {"laminar/B738/button/fmc1_1", "laminar/B738/button/fmc1_2",
+                                         "laminar/B738/button/fmc1_3"}) && ok;
+    SetScratchpad(scratchpad, "", 24, '\0', true);
+    Type(host, "4");
+    ok = ExpectCommands("after a failed write", {"laminar/B738/button/fmc1_4"}) && ok;
+    host.Unload();
+    ok = ExpectLogged("failed write", "does not take writes") && ok;
+    return ok;
+}
+
+// Every broken profile file is reported, however many there are, and messages over a call
+// site's rate limit are still counted in the log
+static bool LogScenario()
+{
+    const int broken_profiles = 8;
+    for (int i = 1; i <= broken_profiles; i++) {
+        char file_name[32];
+        snprintf(file_name, sizeof(file_name), "bad%d.profile", i);
+        WriteProfile(file_name, "name = Broken\nnot a setting\n");
+    }
+    PluginHost host;
+    bool ok = StartSession(host, true);
+    host.RunFrames(1);   // Writes out the log
+    for (int i = 1; i <= broken_profiles; i++) {
+        char file_name[32];
+        snprintf(file_name, sizeof(file_name), "bad%d.profile", i);
+        if (ok) ok = ExpectLogged("broken profiles", file_name) && ok;
+        RemoveProfile(file_name);
+    }
+    if (!ok) return false;
+
+    // 256 keystrokes fill the Captain queue; each of the rest logs "Command queue full"
+    host.LoadAircraft(AIRCRAFT_PRESET_ZIBO_737);
+    host.RunUntilIdle();
+    std::string text(300, 'A');
+    InjectText(host, FMC_KEYBOARD_SIDE_CAPTAIN, text.c_str());
+    host.Unload();
+    ok = ExpectLogged("queue overflow", "39 more messages like \"Command queue full, dropping keystrokes\" suppressed") && ok;
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--plugin") == 0 && i + 1 < argc) {
+            g_plugin_path = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: fmc_scenario_tests [--plugin lin.xpl]\n");
+            return 2;
+        }
+    }
+
+    struct Scenario {
+        const char* name;
+        bool (*run)();
+    };
+    const Scenario scenarios[] = {
+        {"detection", DetectionScenario},
+        {"aircraft_switch", AircraftSwitchScenario},
+        {"late_commands", LateCommandsScenario},
+        {"cache_missing_command", CacheMissingCommandScenario},
+        {"cache_overturned", CacheOverturnedScenario},
+        {"pacing", PacingScenario},
+        {"text_injection", TextInjectionScenario},
+        {"hold_mode", HoldModeScenario},
+        {"repeat_policy", RepeatPolicyScenario},
+        {"sign_tracking", SignTrackingScenario},
+        {"scratchpad_write", ScratchpadWriteScenario},
+        {"log", LogScenario},
+    };
+
+    int failed = 0;
+    for (const Scenario& scenario : scenarios) {
+        bool passed = scenario.run();
+        printf("%s %s\n", passed ? "PASS" : "FAIL", scenario.name);
+        if (!passed) failed++;
+    }
+    printf("%d of %d scenarios passed\n", (int)(sizeof(scenarios) / sizeof(scenarios[0])) - failed,
+           (int)(sizeof(scenarios) / sizeof(scenarios[0])));
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,804 @@
+// Headless XPLM stand-in
+//
+// Implements the subset of XPLM_64.so used by the plugin so lin.xpl can be loaded and
+// driven on a plain Linux box without X-Plane. See XPLMStub.h for the control interface.
+
+#define XPLM200 1
+#define XPLM210 1
+#define XPLM300 1
+#define XPLM301 1
+#include "XPLMDefs.h"
+#include "XPLMDataAccess.h"
+#include "XPLMDisplay.h"
+#include "XPLMGraphics.h"
+#include "XPLMPlanes.h"
+#include "XPLMPlugin.h"
+#include "XPLMProcessing.h"
+#include "XPLMUtilities.h"
+#include "XPLMStub.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct StubCommandHandler {
+    XPLMCommandCallback_f callback;
+    int before;
+    void* refcon;
+};
+
+struct StubCommand {
+    std::string name;
+    std::string description;
+    bool hidden;
+    std::vector<StubCommandHandler> handlers;
+};
+
+struct StubDataRef {
+    std::string name;
+    XPLMDataTypeID type;
+    int writable;
+    bool owned;                        // Simulator-owned value (vs. plugin accessor)
+    int int_value;
+    std::vector<unsigned char> bytes;
+    // Plugin-registered accessors
+    XPLMGetDatai_f get_int;
+    XPLMSetDatai_f set_int;
+    XPLMGetDataf_f get_float;
+    XPLMSetDataf_f set_float;
+    XPLMGetDatad_f get_double;
+    XPLMSetDatad_f set_double;
+    XPLMGetDatavi_f get_int_array;
+    XPLMSetDatavi_f set_int_array;
+    XPLMGetDatavf_f get_float_array;
+    XPLMSetDatavf_f set_float_array;
+    XPLMGetDatab_f get_bytes;
+    XPLMSetDatab_f set_bytes;
+    void* read_refcon;
+    void* write_refcon;
+};
+
+struct StubKeySniffer {
+    XPLMKeySniffer_f callback;
+    int before_windows;
+    void* refcon;
+};
+
+struct StubWindow {
+    XPLMCreateWindow_t params;
+};
+
+struct StubFlightLoop {
+    XPLMFlightLoop_f callback;
+    void* refcon;
+    float interval;                    // 0 = unscheduled, > 0 seconds, < 0 frames
+    double next_time;
+    int next_cycle;
+    double last_call_time;
+    int counter;
+    bool destroyed;
+};
+
+struct StubState {
+    std::vector<std::unique_ptr<StubCommand>> commands;
+    std::map<std::string, StubCommand*> commands_by_name;
+    std::vector<std::unique_ptr<StubDataRef>> datarefs;
+    std::map<std::string, StubDataRef*> datarefs_by_name;
+    std::vector<StubKeySniffer> key_sniffers;
+    std::vector<std::unique_ptr<StubWindow>> windows;
+    std::vector<std::unique_ptr<StubFlightLoop>> flight_loops;
+    std::vector<XPLMStubCommandEvent> command_events;
+    long long counters[XPLMSTUB_COUNTER_COUNT];
+    std::string debug_log;
+    std::string last_drawn_string;
+    std::string plugin_path;
+    std::string aircraft_file_name;    // User aircraft .acf, as XPLMGetNthAircraftModel reports it
+    std::string aircraft_path;
+    double elapsed_time;
+    int cycle;
+    bool echo_log;
+};
+
+StubState& State()
+{
+    static StubState state = [] {
+        StubState initial;
+        memset(initial.counters, 0, sizeof(initial.counters));
+        initial.elapsed_time = 0.0;
+        initial.cycle = 0;
+        initial.plugin_path = "lin.xpl";
+        const char* echo = getenv("XPLM_STUB_ECHO");
+        initial.echo_log = (echo != NULL && echo[0] == '1');
+        return initial;
+    }();
+    return state;
+}
+
+StubCommand* FindOrCreateCommand(const char* name, const char* description)
+{
+    StubState& state = State();
+    std::map<std::string, StubCommand*>::iterator it = state.commands_by_name.find(name);
+    if (it != state.commands_by_name.end()) {
+        return it->second;
+    }
+    std::unique_ptr<StubCommand> command(new StubCommand());
+    command->name = name;
+    command->description = description ? description : "";
+    command->hidden = false;
+    StubCommand* result = command.get();
+    state.commands.push_back(std::move(command));
+    state.commands_by_name[result->name] = result;
+    return result;
+}
+
+StubDataRef* FindOrCreateDataRef(const char* name)
+{
+    StubState& state = State();
+    std::map<std::string, StubDataRef*>::iterator it = state.datarefs_by_name.find(name);
+    if (it != state.datarefs_by_name.end()) {
+        return it->second;
+    }
+    std::unique_ptr<StubDataRef> dataref(new StubDataRef());
+    dataref->name = name;
+    dataref->type = xplmType_Unknown;
+    dataref->writable = 0;
+    dataref->owned = true;
+    dataref->int_value = 0;
+    StubDataRef* result = dataref.get();
+    state.datarefs.push_back(std::move(dataref));
+    state.datarefs_by_name[result->name] = result;
+    return result;
+}
+
+// Run a command's handlers for one phase; returns 0 if a handler consumed it
+int RunHandlers(StubCommand* command, XPLMCommandPhase phase)
+{
+    // Copy so handlers may (un)register handlers while running
+    std::vector<StubCommandHandler> handlers = command->handlers;
+    for (size_t i = 0; i < handlers.size(); i++) {
+        if (handlers[i].callback((XPLMCommandRef)command, phase, handlers[i].refcon) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void RecordCommand(StubCommand* command, int phase)
+{
+    XPLMStubCommandEvent event;
+    event.name = command->name.c_str();
+    event.phase = phase;
+    event.cycle = State().cycle;
+    State().command_events.push_back(event);
+}
+
+} // namespace
+
+/***************************************************************************
+ * XPLMUtilities
+ ***************************************************************************/
+
+XPLM_API void XPLMDebugString(const char* inString)
+{
+    StubState& state = State();
+    state.counters[XPLMSTUB_DEBUG_STRING]++;
+    state.debug_log += inString;
+    if (state.echo_log) {
+        fputs(inString, stderr);
+    }
+}
+
+// Real directory listing, sorted so runs are reproducible
+XPLM_API int XPLMGetDirectoryContents(const char* inDirectoryPath, int inFirstReturn, char* outFileNames, int inFileNameBufSize,
+                                      char** outIndices, int inIndexCount, int* outTotalFiles, int* outReturnedFiles)
+{
+    std::vector<std::string> names;
+    DIR* directory = opendir(inDirectoryPath);
+    if (directory != NULL) {
+        while (struct dirent* entry = readdir(directory)) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                names.push_back(entry->d_name);
+            }
+        }
+        closedir(directory);
+    }
+    std::sort(names.begin(), names.end());
+
+    int returned = 0;
+    int used = 0;
+    for (size_t i = (inFirstReturn > 0) ? (size_t)inFirstReturn : 0; i < names.size(); i++) {
+        int size = (int)names[i].size() + 1;
+        if (returned >= inIndexCount || used + size > inFileNameBufSize) break;
+        memcpy(outFileNames + used, names[i].c_str(), size);
+        if (outIndices) outIndices[returned] = outFileNames + used;
+        used += size;
+        returned++;
+    }
+    if (outTotalFiles) *outTotalFiles = (int)names.size();
+    if (outReturnedFiles) *outReturnedFiles = returned;
+    return (directory != NULL && inFirstReturn + returned >= (int)names.size()) ? 1 : 0;
+}
+
+XPLM_API XPLMCommandRef XPLMFindCommand(const char* inName)
+{
+    StubState& state = State();
+    state.counters[XPLMSTUB_FIND_COMMAND]++;
+    std::map<std::string, StubCommand*>::iterator it = state.commands_by_name.find(inName);
+    if (it == state.commands_by_name.end() || it->second->hidden) {
+        return NULL;
+    }
+    return (XPLMCommandRef)it->second;
+}
+
+XPLM_API XPLMCommandRef XPLMCreateCommand(const char* inName, const char* inDescription)
+{
+    return (XPLMCommandRef)FindOrCreateCommand(inName, inDescription);
+}
+
+XPLM_API void XPLMCommandOnce(XPLMCommandRef inCommand)
+{
+    StubCommand* command = (StubCommand*)inCommand;
+    State().counters[XPLMSTUB_COMMAND_ONCE]++;
+    RecordCommand(command, -1);
+    if (RunHandlers(command, xplm_CommandBegin)) {
+        RunHandlers(command, xplm_CommandEnd);
+    }
+}
+
+XPLM_API void XPLMCommandBegin(XPLMCommandRef inCommand)
+{
+    StubCommand* command = (StubCommand*)inCommand;
+    State().counters[XPLMSTUB_COMMAND_BEGIN]++;
+    RecordCommand(command, xplm_CommandBegin);
+    RunHandlers(command, xplm_CommandBegin);
+}
+
+XPLM_API void XPLMCommandEnd(XPLMCommandRef inCommand)
+{
+    StubCommand* command = (StubCommand*)inCommand;
+    State().counters[XPLMSTUB_COMMAND_END]++;
+    RecordCommand(command, xplm_CommandEnd);
+    RunHandlers(command, xplm_CommandEnd);
+}
+
+XPLM_API void XPLMRegisterCommandHandler(XPLMCommandRef inComand, XPLMCommandCallback_f inHandler, int inBefore, void* inRefcon)
+{
+    StubCommandHandler handler = {inHandler, inBefore, inRefcon};
+    ((StubCommand*)inComand)->handlers.push_back(handler);
+}
+
+XPLM_API void XPLMUnregisterCommandHandler(XPLMCommandRef inComand, XPLMCommandCallback_f inHandler, int inBefore, void* inRefcon)
+{
+    std::vector<StubCommandHandler>& handlers = ((StubCommand*)inComand)->handlers;
+    for (size_t i = 0; i < handlers.size(); i++) {
+        if (handlers[i].callback == inHandler && handlers[i].before == inBefore && handlers[i].refcon == inRefcon) {
+            handlers.erase(handlers.begin() + i);
+            return;
+        }
+    }
+}
+
+/***************************************************************************
+ * XPLMDataAccess
+ ***************************************************************************/
+
+XPLM_API XPLMDataRef XPLMFindDataRef(const char* inDataRefName)
+{
+    StubState& state = State();
+    state.counters[XPLMSTUB_FIND_DATAREF]++;
+    std::map<std::string, StubDataRef*>::iterator it = state.datarefs_by_name.find(inDataRefName);
+    return (it != state.datarefs_by_name.end()) ? (XPLMDataRef)it->second : NULL;
+}
+
+XPLM_API int XPLMCanWriteDataRef(XPLMDataRef inDataRef)
+{
+    return inDataRef ? ((StubDataRef*)inDataRef)->writable : 0;
+}
+
+XPLM_API int XPLMIsDataRefGood(XPLMDataRef inDataRef)
+{
+    return inDataRef != NULL;
+}
+
+XPLM_API XPLMDataTypeID XPLMGetDataRefTypes(XPLMDataRef inDataRef)
+{
+    return inDataRef ? ((StubDataRef*)inDataRef)->type : xplmType_Unknown;
+}
+
+XPLM_API int XPLMGetDatai(XPLMDataRef inDataRef)
+{
+    StubDataRef* dataref = (StubDataRef*)inDataRef;
+    if (dataref == NULL) return 0;
+    if (dataref->owned) return dataref->int_value;
+    return dataref->get_int ? dataref->get_int(dataref->read_refcon) : 0;
+}
+
+XPLM_API void XPLMSetDatai(XPLMDataRef inDataRef, int inValue)
+{
+    StubDataRef* dataref = (StubDataRef*)inDataRef;
+    if (dataref == NULL || !dataref->writable) return;
+    if (dataref->owned) {
+        dataref->int_value = inValue;
+    } else if (dataref->set_int) {
+        dataref->set_int(dataref->write_refcon, inValue);
+    }
+}
+
+XPLM_API float XPLMGetDataf(XPLMDataRef inDataRef)
+{
+    StubDataRef* dataref = (StubDataRef*)inDataRef;
+    if (dataref == NULL) return 0.0f;
+    if (dataref->owned) return (float)dataref->int_value;
+    return dataref->get_float ? dataref->get_float(dataref->read_refcon) : 0.0f;
+}
+
+XPLM_API int XPLMGetDatavi(XPLMDataRef inDataRef, int* outValues, int inOffset, int inMax)
+{
+    StubDataRef* dataref = (StubDataRef*)inDataRef;
+    if (dataref == NULL || dataref->owned || dataref->get_int_array == NULL) return 0;
+    return dataref->get_int_array(dataref->read_refcon, outValues, inOffset, inMax);
+}
+
+XPLM_API void XPLMSetDatavi(XPLMDataRef inDataRef, int* inValues, int inoffset, int inCount)
+{
+    StubDataRef* dataref = (StubDataRef*)inDataRef;
+    if (dataref == NULL || !dataref->writable || dataref->owned || dataref->set_int_array == NULL) return;
+    dataref->set_int_array(dataref->write_refcon, inValues, inoffset, inCount);
+}
+
+XPLM_API int XPLMGetDatab(XPLMDataRef inDataRef, void* outValue, int inOffset, int inMaxBytes)
+{
+    State().counters[XPLMSTUB_GET_DATAB]++;
+    StubDataRef* dataref = (StubDataRef*)inDataRef;
+    if (dataref == NULL) return 0;
+    if (!dataref->owned) {
+        return dataref->get_bytes ? dataref->get_bytes(dataref->read_refcon, outValue, inOffset, inMaxBytes) : 0;
+    }
+    int size = (int)dataref->bytes.size();
+    if (outValue == NULL) return size;
+    if (inOffset < 0 || inOffset >= size) return 0;
+    int copied = (size - inOffset < inMaxBytes) ? size - inOffset : inMaxBytes;
+    memcpy(outValue, dataref->bytes.data() + inOffset, copied);
+    return copied;
+}
+
+XPLM_API void XPLMSetDatab(XPLMDataRef inDataRef, void* inValue, int inOffset, int inLength)
+{
+    State().counters[XPLMSTUB_SET_DATAB]++;
+    StubDataRef* dataref = (StubDataRef*)inDataRef;
+    if (dataref == NULL || !dataref->writable || inOffset < 0 || inLength < 0) return;
+    if (!dataref->owned) {
+        if (dataref->set_bytes) dataref->set_bytes(dataref->write_refcon, inValue, inOffset, inLength);
+        return;
+    }
+    // Byte datarefs have a fixed size in X-Plane; writes past the end are truncated
+    int size = (int)dataref->bytes.size();
+    if (inOffset >= size) return;
+    int copied = (size - inOffset < inLength) ? size - inOffset : inLength;
+    memcpy(dataref->bytes.data() + inOffset, inValue, copied);
+}
+
+XPLM_API XPLMDataRef XPLMRegisterDataAccessor(const char* inDataName, XPLMDataTypeID inDataType, int inIsWritable,
+                                              XPLMGetDatai_f inReadInt, XPLMSetDatai_f inWriteInt,
+                                              XPLMGetDataf_f inReadFloat, XPLMSetDataf_f inWriteFloat,
+                                              XPLMGetDatad_f inReadDouble, XPLMSetDatad_f inWriteDouble,
+                                              XPLMGetDatavi_f inReadIntArray, XPLMSetDatavi_f inWriteIntArray,
+                                              XPLMGetDatavf_f inReadFloatArray, XPLMSetDatavf_f inWriteFloatArray,
+                                              XPLMGetDatab_f inReadData, XPLMSetDatab_f inWriteData,
+                                              void* inReadRefcon, void* inWriteRefcon)
+{
+    StubDataRef* dataref = FindOrCreateDataRef(inDataName);
+    dataref->owned = false;
+    dataref->type = inDataType;
+    dataref->writable = inIsWritable;
+    dataref->get_int = inReadInt;
+    dataref->set_int = inWriteInt;
+    dataref->get_float = inReadFloat;
+    dataref->set_float = inWriteFloat;
+    dataref->get_double = inReadDouble;
+    dataref->set_double = inWriteDouble;
+    dataref->get_int_array = inReadIntArray;
+    dataref->set_int_array = inWriteIntArray;
+    dataref->get_float_array = inReadFloatArray;
+    dataref->set_float_array = inWriteFloatArray;
+    dataref->get_bytes = inReadData;
+    dataref->set_bytes = inWriteData;
+    dataref->read_refcon = inReadRefcon;
+    dataref->write_refcon = inWriteRefcon;
+    return (XPLMDataRef)dataref;
+}
+
+XPLM_API void XPLMUnregisterDataAccessor(XPLMDataRef inDataRef)
+{
+    StubDataRef* dataref = (StubDataRef*)inDataRef;
+    if (dataref == NULL) return;
+    // Keep the object alive (refs may still be held) but make it inert and unfindable
+    dataref->get_int = NULL;
+    dataref->set_int = NULL;
+    dataref->get_int_array = NULL;
+    dataref->set_int_array = NULL;
+    dataref->get_bytes = NULL;
+    dataref->set_bytes = NULL;
+    dataref->writable = 0;
+    State().datarefs_by_name.erase(dataref->name);
+}
+
+/***************************************************************************
+ * XPLMDisplay / XPLMGraphics
+ ***************************************************************************/
+
+XPLM_API int XPLMRegisterKeySniffer(XPLMKeySniffer_f inCallback, int inBeforeWindows, void* inRefcon)
+{
+    StubKeySniffer sniffer = {inCallback, inBeforeWindows, inRefcon};
+    State().key_sniffers.push_back(sniffer);
+    return 1;
+}
+
+XPLM_API int XPLMUnregisterKeySniffer(XPLMKeySniffer_f inCallback, int inBeforeWindows, void* inRefcon)
+{
+    std::vector<StubKeySniffer>& sniffers = State().key_sniffers;
+    for (size_t i = 0; i < sniffers.size(); i++) {
+        if (sniffers[i].callback == inCallback && sniffers[i].before_windows == inBeforeWindows && sniffers[i].refcon == inRefcon) {
+            sniffers.erase(sniffers.begin() + i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+XPLM_API XPLMWindowID XPLMCreateWindowEx(XPLMCreateWindow_t* inParams)
+{
+    std::unique_ptr<StubWindow> window(new StubWindow());
+    memset(&window->params, 0, sizeof(window->params));
+    size_t size = (inParams->structSize < (int)sizeof(window->params)) ? inParams->structSize : sizeof(window->params);
+    memcpy(&window->params, inParams, size);
+    XPLMWindowID result = (XPLMWindowID)window.get();
+    State().windows.push_back(std::move(window));
+    return result;
+}
+
+XPLM_API void XPLMDestroyWindow(XPLMWindowID inWindowID)
+{
+    std::vector<std::unique_ptr<StubWindow>>& windows = State().windows;
+    for (size_t i = 0; i < windows.size(); i++) {
+        if ((XPLMWindowID)windows[i].get() == inWindowID) {
+            windows.erase(windows.begin() + i);
+            return;
+        }
+    }
+}
+
+XPLM_API void XPLMGetScreenSize(int* outWidth, int* outHeight)
+{
+    if (outWidth) *outWidth = 1920;
+    if (outHeight) *outHeight = 1080;
+}
+
+XPLM_API void XPLMGetWindowGeometry(XPLMWindowID inWindowID, int* outLeft, int* outTop, int* outRight, int* outBottom)
+{
+    const XPLMCreateWindow_t& params = ((StubWindow*)inWindowID)->params;
+    if (outLeft) *outLeft = params.left;
+    if (outTop) *outTop = params.top;
+    if (outRight) *outRight = params.right;
+    if (outBottom) *outBottom = params.bottom;
+}
+
+XPLM_API int XPLMGetWindowIsVisible(XPLMWindowID inWindowID)
+{
+    return ((StubWindow*)inWindowID)->params.visible;
+}
+
+XPLM_API void XPLMSetWindowIsVisible(XPLMWindowID inWindowID, int inIsVisible)
+{
+    ((StubWindow*)inWindowID)->params.visible = inIsVisible;
+}
+
+XPLM_API void XPLMSetGraphicsState(int /*inEnableFog*/, int /*inNumberTexUnits*/, int /*inEnableLighting*/, int /*inEnableAlphaTesting*/,
+                                   int /*inEnableAlphaBlending*/, int /*inEnableDepthTesting*/, int /*inEnableDepthWriting*/)
+{
+}
+
+XPLM_API void XPLMDrawTranslucentDarkBox(int /*inLeft*/, int /*inTop*/, int /*inRight*/, int /*inBottom*/)
+{
+}
+
+XPLM_API void XPLMDrawString(float* /*inColorRGB*/, int /*inXOffset*/, int /*inYOffset*/, const char* inChar,
+                             int* /*inWordWrapWidth*/, XPLMFontID /*inFontID*/)
+{
+    State().last_drawn_string = inChar ? inChar : "";
+}
+
+/***************************************************************************
+ * XPLMProcessing
+ ***************************************************************************/
+
+XPLM_API float XPLMGetElapsedTime(void)
+{
+    return (float)State().elapsed_time;
+}
+
+XPLM_API int XPLMGetCycleNumber(void)
+{
+    return State().cycle;
+}
+
+XPLM_API XPLMFlightLoopID XPLMCreateFlightLoop(XPLMCreateFlightLoop_t* inParams)
+{
+    std::unique_ptr<StubFlightLoop> loop(new StubFlightLoop());
+    loop->callback = inParams->callbackFunc;
+    loop->refcon = inParams->refcon;
+    loop->interval = 0.0f;
+    loop->next_time = 0.0;
+    loop->next_cycle = 0;
+    loop->last_call_time = State().elapsed_time;
+    loop->counter = 0;
+    loop->destroyed = false;
+    XPLMFlightLoopID result = (XPLMFlightLoopID)loop.get();
+    State().flight_loops.push_back(std::move(loop));
+    return result;
+}
+
+XPLM_API void XPLMDestroyFlightLoop(XPLMFlightLoopID inFlightLoopID)
+{
+    // Objects are kept until reset so a loop destroying itself mid-frame stays safe
+    StubFlightLoop* loop = (StubFlightLoop*)inFlightLoopID;
+    loop->destroyed = true;
+    loop->interval = 0.0f;
+}
+
+static void ScheduleLoop(StubFlightLoop* loop, float interval)
+{
+    const StubState& state = State();
+    loop->interval = interval;
+    if (interval > 0.0f) {
+        loop->next_time = state.elapsed_time + interval;
+    } else if (interval < 0.0f) {
+        loop->next_cycle = state.cycle + (int)(-interval);
+    }
+}
+
+XPLM_API void XPLMScheduleFlightLoop(XPLMFlightLoopID inFlightLoopID, float inInterval, int /*inRelativeToNow*/)
+{
+    StubFlightLoop* loop = (StubFlightLoop*)inFlightLoopID;
+    if (loop->destroyed) return;
+    ScheduleLoop(loop, inInterval);
+}
+
+/***************************************************************************
+ * XPLMPlugin
+ ***************************************************************************/
+
+// The stub hosts a single plugin
+static const XPLMPluginID STUB_PLUGIN_ID = 1;
+
+XPLM_API XPLMPluginID XPLMGetMyID(void)
+{
+    return STUB_PLUGIN_ID;
+}
+
+XPLM_API void XPLMGetPluginInfo(XPLMPluginID inPlugin, char* outName, char* outFilePath, char* outSignature, char* outDescription)
+{
+    if (inPlugin != STUB_PLUGIN_ID) {
+        return;
+    }
+    // Buffers are 256 bytes per the SDK
+    if (outName) snprintf(outName, 256, "%s", "Plugin under test");
+    if (outFilePath) snprintf(outFilePath, 256, "%s", State().plugin_path.c_str());
+    if (outSignature) snprintf(outSignature, 256, "%s", "");
+    if (outDescription) snprintf(outDescription, 256, "%s", "");
+}
+
+XPLM_API int XPLMHasFeature(const char* inFeature)
+{
+    return strcmp(inFeature, "XPLM_USE_NATIVE_PATHS") == 0;
+}
+
+XPLM_API int XPLMIsFeatureEnabled(const char* inFeature)
+{
+    return XPLMHasFeature(inFeature);   // Paths are always native
+}
+
+XPLM_API void XPLMEnableFeature(const char* /*inFeature*/, int /*inEnable*/)
+{
+}
+
+XPLM_API void XPLMGetNthAircraftModel(int inIndex, char* outFileName, char* outPath)
+{
+    // Buffers are 256 (file name) and 512 (path) bytes per the SDK; only the user aircraft is loaded
+    StubState& state = State();
+    bool user = (inIndex == XPLM_USER_AIRCRAFT);
+    if (outFileName) snprintf(outFileName, 256, "%s", user ? state.aircraft_file_name.c_str() : "");
+    if (outPath) snprintf(outPath, 512, "%s", user ? state.aircraft_path.c_str() : "");
+}
+
+/***************************************************************************
+ * Control interface
+ ***************************************************************************/
+
+XPLM_API void XPLMStub_Reset(void)
+{
+    StubState& state = State();
+    state.commands_by_name.clear();
+    state.commands.clear();
+    state.datarefs_by_name.clear();
+    state.datarefs.clear();
+    state.key_sniffers.clear();
+    state.windows.clear();
+    state.flight_loops.clear();
+    state.command_events.clear();
+    memset(state.counters, 0, sizeof(state.counters));
+    state.debug_log.clear();
+    state.last_drawn_string.clear();
+    state.aircraft_file_name.clear();
+    state.aircraft_path.clear();
+    state.elapsed_time = 0.0;
+    state.cycle = 0;
+}
+
+XPLM_API void XPLMStub_SetPluginPath(const char* inPath)
+{
+    State().plugin_path = inPath;
+}
+
+XPLM_API void XPLMStub_SetAircraftModel(const char* inFileName, const char* inPath)
+{
+    State().aircraft_file_name = inFileName;
+    State().aircraft_path = inPath;
+}
+
+XPLM_API void XPLMStub_AddCommand(const char* inName)
+{
+    FindOrCreateCommand(inName, NULL)->hidden = false;
+}
+
+XPLM_API void XPLMStub_SetCommandHidden(const char* inName, int inHidden)
+{
+    std::map<std::string, StubCommand*>::iterator it = State().commands_by_name.find(inName);
+    if (it != State().commands_by_name.end()) {
+        it->second->hidden = (inHidden != 0);
+    }
+}
+
+XPLM_API void XPLMStub_InvokeCommand(const char* inName)
+{
+    std::map<std::string, StubCommand*>::iterator it = State().commands_by_name.find(inName);
+    if (it != State().commands_by_name.end()) {
+        if (RunHandlers(it->second, xplm_CommandBegin)) {
+            RunHandlers(it->second, xplm_CommandEnd);
+        }
+    }
+}
+
+XPLM_API void XPLMStub_SetDatab(const char* inName, const void* inValue, int inLength, int inWritable)
+{
+    StubDataRef* dataref = FindOrCreateDataRef(inName);
+    dataref->owned = true;
+    dataref->type = xplmType_Data;
+    dataref->writable = inWritable;
+    dataref->bytes.assign((const unsigned char*)inValue, (const unsigned char*)inValue + inLength);
+}
+
+XPLM_API void XPLMStub_SetDatai(const char* inName, int inValue)
+{
+    StubDataRef* dataref = FindOrCreateDataRef(inName);
+    dataref->owned = true;
+    dataref->type = xplmType_Int;
+    dataref->int_value = inValue;
+}
+
+XPLM_API void XPLMStub_RemoveDataRef(const char* inName)
+{
+    // The object stays alive for refs already handed out, like an orphaned dataref
+    State().datarefs_by_name.erase(inName);
+}
+
+XPLM_API int XPLMStub_SendKey(char inChar, XPLMKeyFlags inFlags, char inVirtualKey)
+{
+    // Before-windows sniffers run first, then the after-windows ones
+    std::vector<StubKeySniffer> sniffers = State().key_sniffers;
+    for (int pass = 1; pass >= 0; pass--) {
+        for (size_t i = 0; i < sniffers.size(); i++) {
+            if ((sniffers[i].before_windows != 0) == (pass == 1) &&
+                sniffers[i].callback(inChar, inFlags, inVirtualKey, sniffers[i].refcon) == 0) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+XPLM_API int XPLMStub_CountKeySniffers(void)
+{
+    return (int)State().key_sniffers.size();
+}
+
+XPLM_API void XPLMStub_RunFrame(float inSeconds)
+{
+    StubState& state = State();
+    state.elapsed_time += inSeconds;
+    state.cycle++;
+
+    // Index loop: callbacks may create flight loops while we iterate
+    for (size_t i = 0; i < state.flight_loops.size(); i++) {
+        StubFlightLoop* loop = state.flight_loops[i].get();
+        if (loop->destroyed || loop->interval == 0.0f) continue;
+        bool due = (loop->interval > 0.0f) ? (state.elapsed_time >= loop->next_time) : (state.cycle >= loop->next_cycle);
+        if (!due) continue;
+
+        float since_last_call = (float)(state.elapsed_time - loop->last_call_time);
+        loop->last_call_time = state.elapsed_time;
+        float next = loop->callback(since_last_call, inSeconds, ++loop->counter, loop->refcon);
+        if (!loop->destroyed) {
+            ScheduleLoop(loop, next);
+        }
+    }
+}
+
+XPLM_API void XPLMStub_DrawWindows(void)
+{
+    std::vector<std::unique_ptr<StubWindow>>& windows = State().windows;
+    for (size_t i = 0; i < windows.size(); i++) {
+        if (windows[i]->params.visible && windows[i]->params.drawWindowFunc) {
+            windows[i]->params.drawWindowFunc((XPLMWindowID)windows[i].get(), windows[i]->params.refcon);
+        }
+    }
+}
+
+XPLM_API const char* XPLMStub_GetLastDrawnString(void)
+{
+    return State().last_drawn_string.c_str();
+}
+
+XPLM_API int XPLMStub_CountVisibleWindows(void)
+{
+    int count = 0;
+    std::vector<std::unique_ptr<StubWindow>>& windows = State().windows;
+    for (size_t i = 0; i < windows.size(); i++) {
+        if (windows[i]->params.visible) count++;
+    }
+    return count;
+}
+
+XPLM_API int XPLMStub_CountCommandEvents(void)
+{
+    return (int)State().command_events.size();
+}
+
+XPLM_API XPLMStubCommandEvent XPLMStub_GetCommandEvent(int inIndex)
+{
+    return State().command_events[inIndex];
+}
+
+XPLM_API void XPLMStub_ClearCommandEvents(void)
+{
+    State().command_events.clear();
+}
+
+XPLM_API long long XPLMStub_GetCounter(enum XPLMStubCounter inCounter)
+{
+    return State().counters[inCounter];
+}
+
+XPLM_API void XPLMStub_ResetCounters(void)
+{
+    memset(State().counters, 0, sizeof(State().counters));
+}
+
+XPLM_API const char* XPLMStub_GetDebugLog(void)
+{
+    return State().debug_log.c_str();
+}
+
+XPLM_API void XPLMStub_ClearDebugLog(void)
+{
+    State().debug_log.clear();
+}
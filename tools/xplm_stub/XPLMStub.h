@@ -0,0 +1,90 @@
+// Headless XPLM stand-in - control interface
+//
+// XPLMStub.cpp builds a fake XPLM_64.so that implements the subset of the X-Plane SDK
+// used by the plugin. Besides the XPLM API itself it exports the XPLMStub_* functions
+// below, which a host program uses to play the simulator: publish aircraft commands and
+// datarefs, deliver key events, advance frames and inspect what the plugin did.
+
+#ifndef XPLM_STUB_H
+#define XPLM_STUB_H
+
+#include "XPLMDefs.h"
+#include "XPLMUtilities.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Call counters for the XPLM functions that matter on the plugin's hot paths
+enum XPLMStubCounter {
+    XPLMSTUB_FIND_COMMAND = 0,
+    XPLMSTUB_COMMAND_ONCE,
+    XPLMSTUB_COMMAND_BEGIN,
+    XPLMSTUB_COMMAND_END,
+    XPLMSTUB_FIND_DATAREF,
+    XPLMSTUB_GET_DATAB,
+    XPLMSTUB_SET_DATAB,
+    XPLMSTUB_DEBUG_STRING,
+    XPLMSTUB_COUNTER_COUNT
+};
+
+// One command fired by the plugin (XPLMCommandOnce/Begin/End)
+typedef struct {
+    const char* name;       // Command name, valid for the life of the stub
+    int phase;              // -1 = once, otherwise xplm_CommandBegin / xplm_CommandEnd
+    int cycle;              // XPLMGetCycleNumber() when the command was fired
+} XPLMStubCommandEvent;
+
+// Forget commands, datarefs, callbacks, windows and logs. Only call with no plugin loaded.
+XPLM_API void XPLMStub_Reset(void);
+
+// File path XPLMGetPluginInfo reports for the plugin (its folder is where it writes files)
+XPLM_API void XPLMStub_SetPluginPath(const char* inPath);
+
+// .acf file name and full path XPLMGetNthAircraftModel reports for the user aircraft
+XPLM_API void XPLMStub_SetAircraftModel(const char* inFileName, const char* inPath);
+
+// Commands provided by the "aircraft". Hidden commands stay valid for refs already
+// handed out (as in X-Plane) but are no longer returned by XPLMFindCommand.
+XPLM_API void XPLMStub_AddCommand(const char* inName);
+XPLM_API void XPLMStub_SetCommandHidden(const char* inName, int inHidden);
+
+// Run the handlers of a command as if the user pressed its key binding (not logged or counted)
+XPLM_API void XPLMStub_InvokeCommand(const char* inName);
+
+// Simulator-owned datarefs. Setting a value creates the dataref if needed.
+XPLM_API void XPLMStub_SetDatab(const char* inName, const void* inValue, int inLength, int inWritable);
+XPLM_API void XPLMStub_SetDatai(const char* inName, int inValue);
+XPLM_API void XPLMStub_RemoveDataRef(const char* inName);
+
+// Deliver a key event to the registered key sniffers. Returns 1 if every sniffer passed it on.
+XPLM_API int XPLMStub_SendKey(char inChar, XPLMKeyFlags inFlags, char inVirtualKey);
+XPLM_API int XPLMStub_CountKeySniffers(void);
+
+// Advance the clock by inSeconds and run every flight loop that is due
+XPLM_API void XPLMStub_RunFrame(float inSeconds);
+
+// Call the draw callback of every visible window
+XPLM_API void XPLMStub_DrawWindows(void);
+XPLM_API const char* XPLMStub_GetLastDrawnString(void);
+XPLM_API int XPLMStub_CountVisibleWindows(void);
+
+// Commands fired by the plugin since the last clear
+XPLM_API int XPLMStub_CountCommandEvents(void);
+XPLM_API XPLMStubCommandEvent XPLMStub_GetCommandEvent(int inIndex);
+XPLM_API void XPLMStub_ClearCommandEvents(void);
+
+// Call counters
+XPLM_API long long XPLMStub_GetCounter(enum XPLMStubCounter inCounter);
+XPLM_API void XPLMStub_ResetCounters(void);
+
+// Everything passed to XPLMDebugString since the last clear. Set XPLM_STUB_ECHO=1 in the
+// environment to also echo it to stderr.
+XPLM_API const char* XPLMStub_GetDebugLog(void);
+XPLM_API void XPLMStub_ClearDebugLog(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // XPLM_STUB_H